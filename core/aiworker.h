@@ -0,0 +1,168 @@
+#ifndef AIWORKER_H
+#define AIWORKER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "mnk.h"
+#include "search.h"
+
+// Background thread that computes AI moves so the frame loop never blocks.
+// The GUI submits a job, keeps drawing, and polls every frame for the result.
+typedef struct AIJob AIJob;
+typedef SearchResult (*AIJobFn)(const AIJob *job, SearchProgress *progress);
+
+struct AIJob {
+  AIJobFn run;         // Engine that picks the move
+  MnkVariant variant;
+  MnkBoard board;      // Copy of the position, the GUI may keep drawing its own
+  int player;          // Side the AI plays
+  const void *engine;  // Extra engine input such as model weights
+};
+
+typedef enum { AI_WORKER_IDLE,
+               AI_WORKER_RUNNING,
+               AI_WORKER_DONE } AIWorkerState;
+
+typedef struct {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  AIJob job;
+  SearchResult result;
+  SearchProgress progress;
+  AIWorkerState state;
+  double startedMs;  // When the current job was submitted
+  bool pending;      // Job submitted but not picked up yet
+  bool cancelled;    // Result of the running job is to be dropped
+  bool shutdown;
+  bool started;
+} AIWorker;
+
+// Engines log the moves they pick to the console, the headless tools turn it off
+extern bool aiLog;
+
+// function prototypes
+bool ai_worker_start(AIWorker *worker);
+bool ai_worker_submit(AIWorker *worker, const AIJob *job);
+bool ai_worker_poll(AIWorker *worker, SearchResult *result);
+bool ai_worker_busy(AIWorker *worker);
+void ai_worker_cancel(AIWorker *worker);
+void ai_worker_stop(AIWorker *worker);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+bool aiLog = true;
+
+static void *ai_worker_main(void *arg) {
+  AIWorker *worker = (AIWorker *)arg;
+
+  pthread_mutex_lock(&worker->lock);
+  while (true) {
+    while (!worker->shutdown && !worker->pending) pthread_cond_wait(&worker->wake, &worker->lock);
+    if (worker->shutdown) break;
+    worker->pending = false;
+    AIJob job = worker->job;
+    pthread_mutex_unlock(&worker->lock);
+
+    SearchResult result = job.run(&job, &worker->progress);
+
+    pthread_mutex_lock(&worker->lock);
+    worker->result = result;
+    worker->state = worker->cancelled ? AI_WORKER_IDLE : AI_WORKER_DONE;
+    worker->cancelled = false;
+  }
+  pthread_mutex_unlock(&worker->lock);
+  return NULL;
+}
+
+bool ai_worker_start(AIWorker *worker) {
+  pthread_mutex_init(&worker->lock, NULL);
+  pthread_cond_init(&worker->wake, NULL);
+  worker->state = AI_WORKER_IDLE;
+  worker->pending = false;
+  worker->cancelled = false;
+  worker->shutdown = false;
+  worker->started = pthread_create(&worker->thread, NULL, ai_worker_main, worker) == 0;
+  return worker->started;
+}
+
+// Hand a job to the worker, returns false while a previous job is still running.
+// Without a worker thread the job runs right away on the caller
+bool ai_worker_submit(AIWorker *worker, const AIJob *job) {
+  pthread_mutex_lock(&worker->lock);
+  bool accepted = worker->state == AI_WORKER_IDLE;
+  if (accepted) {
+    atomic_store(&worker->progress.cancel, false);
+    atomic_store(&worker->progress.depth, 0);
+    atomic_store(&worker->progress.nodes, 0);
+    worker->job = *job;
+    worker->startedMs = search_now_ms();
+  }
+  if (accepted && !worker->started) {
+    pthread_mutex_unlock(&worker->lock);
+    worker->result = job->run(&worker->job, &worker->progress);
+    worker->state = AI_WORKER_DONE;
+    return true;
+  }
+  if (accepted) {
+    worker->state = AI_WORKER_RUNNING;
+    worker->pending = true;
+    pthread_cond_signal(&worker->wake);
+  }
+  pthread_mutex_unlock(&worker->lock);
+  return accepted;
+}
+
+// Check for a finished move. Returns true once, handing over the result
+bool ai_worker_poll(AIWorker *worker, SearchResult *result) {
+  pthread_mutex_lock(&worker->lock);
+  bool done = worker->state == AI_WORKER_DONE;
+  if (done) {
+    *result = worker->result;
+    worker->state = AI_WORKER_IDLE;
+  }
+  pthread_mutex_unlock(&worker->lock);
+  return done;
+}
+
+// True while a job is queued, running or waiting to be polled
+bool ai_worker_busy(AIWorker *worker) {
+  pthread_mutex_lock(&worker->lock);
+  bool busy = worker->state != AI_WORKER_IDLE;
+  pthread_mutex_unlock(&worker->lock);
+  return busy;
+}
+
+// Stop the current job as soon as possible and drop its result
+void ai_worker_cancel(AIWorker *worker) {
+  pthread_mutex_lock(&worker->lock);
+  if (worker->state == AI_WORKER_RUNNING) {
+    worker->cancelled = true;
+    atomic_store(&worker->progress.cancel, true);
+  } else if (worker->state == AI_WORKER_DONE) {
+    worker->state = AI_WORKER_IDLE;
+  }
+  pthread_mutex_unlock(&worker->lock);
+}
+
+// Cancel whatever is running and join the thread
+void ai_worker_stop(AIWorker *worker) {
+  if (!worker->started) return;
+  ai_worker_cancel(worker);
+
+  pthread_mutex_lock(&worker->lock);
+  worker->shutdown = true;
+  pthread_cond_signal(&worker->wake);
+  pthread_mutex_unlock(&worker->lock);
+
+  pthread_join(worker->thread, NULL);
+  pthread_mutex_destroy(&worker->lock);
+  pthread_cond_destroy(&worker->wake);
+  worker->started = false;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tic-Tac-Toe board constants
+#define EMPTY 0
+#define X 1
+#define O -1
+#define TIE 2
+
+// Bitboard layout: bit i is set when cell i (row * 3 + col) is taken
+#define BB_CELLS 9
+#define BB_FULL 0x1FF  // All nine cells occupied
+#define BB_NUM_LINES 8
+
+typedef uint16_t BBMask;
+
+// Board state as one occupancy mask per side (4 bytes instead of 36)
+typedef struct {
+  BBMask x;  // Cells taken by X
+  BBMask o;  // Cells taken by O
+} Bitboard;
+
+// Winning lines, in the same order as the win_patterns table of check_winner
+static const BBMask BB_WIN_MASKS[BB_NUM_LINES] = {
+    0x007, 0x038, 0x1C0,  // Rows
+    0x049, 0x092, 0x124,  // Columns
+    0x111, 0x054          // Diagonals
+};
+
+// function prototypes
+int bb_check_winner(Bitboard board);
+Bitboard bb_from_array(const int board[BB_CELLS]);
+void bb_to_array(Bitboard board, int out[BB_CELLS]);
+int check_winner(int board[BB_CELLS]);  // assembly version on ARM, see checkWinner.s
+int check_winner_c(int board[BB_CELLS]);
+
+// Clear every cell of the board
+static inline void bb_clear(Bitboard *board) {
+  board->x = 0;
+  board->o = 0;
+}
+
+// Mask of all cells that are still free
+static inline BBMask bb_empty(Bitboard board) {
+  return (BBMask)(~(board.x | board.o) & BB_FULL);
+}
+
+// Returns X, O or EMPTY for a single cell
+static inline int bb_cell(Bitboard board, int cell) {
+  if (board.x & (1u << cell)) return X;
+  if (board.o & (1u << cell)) return O;
+  return EMPTY;
+}
+
+// Place a piece for player on an empty cell
+static inline void bb_make_move(Bitboard *board, int cell, int player) {
+  if (player == X)
+    board->x |= (BBMask)(1u << cell);
+  else
+    board->o |= (BBMask)(1u << cell);
+}
+
+// Take back whichever piece sits on cell
+static inline void bb_unmake_move(Bitboard *board, int cell) {
+  board->x &= (BBMask)~(1u << cell);
+  board->o &= (BBMask)~(1u << cell);
+}
+
+static inline int bb_popcount(BBMask mask) { return __builtin_popcount(mask); }
+
+// Returns the index of the lowest set cell and clears it from mask,
+// used to walk the empty cells without scanning the whole board
+static inline int bb_pop_lsb(BBMask *mask) {
+  int cell = __builtin_ctz(*mask);
+  *mask &= (BBMask)(*mask - 1);
+  return cell;
+}
+
+// True if the given side mask completes any winning line
+static inline bool bb_has_line(BBMask side) {
+  for (int i = 0; i < BB_NUM_LINES; i++) {
+    if ((side & BB_WIN_MASKS[i]) == BB_WIN_MASKS[i]) return true;
+  }
+  return false;
+}
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Bitboard equivalent of check_winner: X, O, TIE or EMPTY (ongoing)
+int bb_check_winner(Bitboard board) {
+  for (int i = 0; i < BB_NUM_LINES; i++) {
+    const BBMask line = BB_WIN_MASKS[i];
+    if ((board.x & line) == line) return X;
+    if ((board.o & line) == line) return O;
+  }
+
+  if ((board.x | board.o) == BB_FULL) return TIE;
+
+  return EMPTY;  // Game is still ongoing
+}
+
+// Convert a 9 cell int board (X = 1, O = -1) into a bitboard
+Bitboard bb_from_array(const int board[BB_CELLS]) {
+  Bitboard result = {0, 0};
+  for (int i = 0; i < BB_CELLS; i++) {
+    if (board[i] != EMPTY) bb_make_move(&result, i, board[i]);
+  }
+  return result;
+}
+
+// Expand a bitboard back into the 9 cell int layout used by the ML features
+void bb_to_array(Bitboard board, int out[BB_CELLS]) {
+  for (int i = 0; i < BB_CELLS; i++) out[i] = bb_cell(board, i);
+}
+
+// Function to check the winner, portable C version of checkWinner.s
+int check_winner_c(int board[BB_CELLS]) {
+  // Define winning patterns as static const to ensure they're only created once
+  static const int win_patterns[][3] = {
+      {0, 1, 2}, {3, 4, 5}, {6, 7, 8},  // Rows
+      {0, 3, 6},
+      {1, 4, 7},
+      {2, 5, 8},  // Columns
+      {0, 4, 8},
+      {2, 4, 6}  // Diagonals
+  };
+  static const int NUM_PATTERNS = 8;
+
+  // Check all winning patterns
+  for (int i = 0; i < NUM_PATTERNS; i++) {
+    const int *pattern = win_patterns[i];
+    if (board[pattern[0]] != EMPTY &&
+        board[pattern[0]] == board[pattern[1]] &&
+        board[pattern[1]] == board[pattern[2]]) {
+      return board[pattern[0]];
+    }
+  }
+
+  // Check for tie
+  bool is_tie = true;
+  for (int i = 0; i < BB_CELLS; i++) {
+    if (board[i] == EMPTY) {
+      is_tie = false;
+      break;
+    }
+  }
+  if (is_tie) return TIE;
+
+  return EMPTY;  // Game is still ongoing
+}
+
+// ARM builds link core/checkWinner.s instead
+#if !defined(__aarch64__)
+int check_winner(int board[BB_CELLS]) { return check_winner_c(board); }
+#endif
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef BITBOARD_BATCH_H
+#define BITBOARD_BATCH_H
+
+#include <stdint.h>
+
+#include "bitboard.h"
+#include "simd.h"
+
+// Batched win detection for many boards at once. Boards come as
+// structure-of-arrays: x[i] and o[i] are the side masks of board i. out[i]
+// receives X, O, TIE or EMPTY, always the same value bb_check_winner and
+// check_winner give for that board. Lanes per instruction: 16 on AVX2,
+// 8 on SSE2 and NEON (simd.h picks the set).
+
+// function prototypes
+void bb_check_winner_batch(const BBMask *x, const BBMask *o, int8_t *out, int count);
+void bb_check_winner_batch_scalar(const BBMask *x, const BBMask *o, int8_t *out, int count);
+const char *bb_batch_backend(void);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Reference loop, also finishes the boards left over by the vector backends
+void bb_check_winner_batch_scalar(const BBMask *x, const BBMask *o, int8_t *out, int count) {
+  for (int i = 0; i < count; i++) {
+    Bitboard board = {x[i], o[i]};
+    out[i] = (int8_t)bb_check_winner(board);
+  }
+}
+
+// The vector backends start every lane at TIE or EMPTY and then walk the
+// lines from last to first, letting each completed line overwrite the lane.
+// The first completed line in check_winner order is therefore the one left,
+// which keeps the result identical on boards where both sides have a line.
+#if defined(SIMD_X86)
+
+static void bb_batch_sse2(const BBMask *x, const BBMask *o, int8_t *out, int count) {
+  const __m128i full = _mm_set1_epi16(BB_FULL);
+  const __m128i winX = _mm_set1_epi16(X);
+  const __m128i winO = _mm_set1_epi16(O);
+  const __m128i tie = _mm_set1_epi16(TIE);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8) {
+    const __m128i vx = _mm_loadu_si128((const __m128i *)(x + i));
+    const __m128i vo = _mm_loadu_si128((const __m128i *)(o + i));
+    __m128i result = _mm_and_si128(_mm_cmpeq_epi16(_mm_or_si128(vx, vo), full), tie);
+
+    for (int l = BB_NUM_LINES - 1; l >= 0; l--) {
+      const __m128i line = _mm_set1_epi16(BB_WIN_MASKS[l]);
+      const __m128i hasO = _mm_cmpeq_epi16(_mm_and_si128(vo, line), line);
+      const __m128i hasX = _mm_cmpeq_epi16(_mm_and_si128(vx, line), line);
+      result = _mm_or_si128(_mm_and_si128(hasO, winO), _mm_andnot_si128(hasO, result));
+      result = _mm_or_si128(_mm_and_si128(hasX, winX), _mm_andnot_si128(hasX, result));
+    }
+    _mm_storel_epi64((__m128i *)(out + i), _mm_packs_epi16(result, result));
+  }
+  bb_check_winner_batch_scalar(x + i, o + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void bb_batch_avx2(const BBMask *x, const BBMask *o,
+                                                          int8_t *out, int count) {
+  const __m256i full = _mm256_set1_epi16(BB_FULL);
+  const __m256i winX = _mm256_set1_epi16(X);
+  const __m256i winO = _mm256_set1_epi16(O);
+  const __m256i tie = _mm256_set1_epi16(TIE);
+  int i = 0;
+
+  for (; i + 16 <= count; i += 16) {
+    const __m256i vx = _mm256_loadu_si256((const __m256i *)(x + i));
+    const __m256i vo = _mm256_loadu_si256((const __m256i *)(o + i));
+    __m256i result = _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_or_si256(vx, vo), full), tie);
+
+    for (int l = BB_NUM_LINES - 1; l >= 0; l--) {
+      const __m256i line = _mm256_set1_epi16(BB_WIN_MASKS[l]);
+      const __m256i hasO = _mm256_cmpeq_epi16(_mm256_and_si256(vo, line), line);
+      const __m256i hasX = _mm256_cmpeq_epi16(_mm256_and_si256(vx, line), line);
+      result = _mm256_blendv_epi8(result, winO, hasO);
+      result = _mm256_blendv_epi8(result, winX, hasX);
+    }
+
+    // Narrow the 16 lanes to bytes, packs works per 128 bit half
+    const __m128i low = _mm256_castsi256_si128(result);
+    const __m128i high = _mm256_extracti128_si256(result, 1);
+    _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi16(low, high));
+  }
+  bb_batch_sse2(x + i, o + i, out + i, count - i);
+}
+
+#elif defined(SIMD_NEON)
+
+static void bb_batch_neon(const BBMask *x, const BBMask *o, int8_t *out, int count) {
+  const uint16x8_t full = vdupq_n_u16(BB_FULL);
+  const int16x8_t winX = vdupq_n_s16(X);
+  const int16x8_t winO = vdupq_n_s16(O);
+  const int16x8_t tie = vdupq_n_s16(TIE);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8) {
+    const uint16x8_t vx = vld1q_u16(x + i);
+    const uint16x8_t vo = vld1q_u16(o + i);
+    int16x8_t result = vbslq_s16(vceqq_u16(vorrq_u16(vx, vo), full), tie, vdupq_n_s16(EMPTY));
+
+    for (int l = BB_NUM_LINES - 1; l >= 0; l--) {
+      const uint16x8_t line = vdupq_n_u16(BB_WIN_MASKS[l]);
+      result = vbslq_s16(vceqq_u16(vandq_u16(vo, line), line), winO, result);
+      result = vbslq_s16(vceqq_u16(vandq_u16(vx, line), line), winX, result);
+    }
+    vst1_s8(out + i, vmovn_s16(result));
+  }
+  bb_check_winner_batch_scalar(x + i, o + i, out + i, count - i);
+}
+
+#endif
+
+void bb_check_winner_batch(const BBMask *x, const BBMask *o, int8_t *out, int count) {
+  switch (simd_level()) {
+#if defined(SIMD_X86)
+    case SIMD_AVX2:
+      bb_batch_avx2(x, o, out, count);
+      return;
+    case SIMD_SSE2:
+      bb_batch_sse2(x, o, out, count);
+      return;
+#elif defined(SIMD_NEON)
+    case SIMD_NEON:
+      bb_batch_neon(x, o, out, count);
+      return;
+#endif
+    default:
+      bb_check_winner_batch_scalar(x, o, out, count);
+  }
+}
+
+// Name of the backend bb_check_winner_batch runs on
+const char *bb_batch_backend(void) { return simd_level_name(simd_level()); }
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,3 @@
+// Builds the engine library (build/libtttengine.a), see engine.h
+#define ENGINE_IMPLEMENTATION
+#include "engine.h"
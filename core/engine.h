@@ -0,0 +1,33 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+// Headless Tic-Tac-Toe engine: boards, win checks, minimax, the perfect-play
+// table, m,n,k search and the ML model. Nothing here depends on raylib, so
+// benchmarks, servers and batch tools can link build/libtttengine.a on their own.
+//
+// The headers only declare the engine. Their definitions are compiled once,
+// in core/engine.c, which defines ENGINE_IMPLEMENTATION before including them
+#include "aiworker.h"
+#include "bitboard.h"
+#include "bitboard_batch.h"
+#include "least_squares.h"
+#include "mcts_engine.h"
+#include "mapped_file.h"
+#include "minimax_engine.h"
+#include "ml_batch.h"
+#include "ml_engine.h"
+#include "mlp.h"
+#include "mnk.h"
+#include "packed_dataset.h"
+#include "perft.h"
+#include "retro.h"
+#include "search.h"
+#include "selfplay.h"
+#include "simd.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "tournament.h"
+#include "train_kernel.h"
+#include "transposition.h"
+
+#endif
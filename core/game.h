@@ -1,17 +1,14 @@
 #include "../include/raylib.h"
+#include "aiworker.h"
+#include "bitboard.h"
+#include "mnk.h"
 
 #define MAX_FEATURES 9
 #define DEBUG 1
 
 #define MAX_FEATURES 9
-#define CELL_SIZE 150  // Size of each grid
-#define GRID_SIZE 3    // Number of grids
-
-// Tic-Tac-Toe board constants
-#define EMPTY 0
-#define X 1
-#define O -1
-#define TIE 2
+#define CELL_SIZE 150  // Size of each grid on the classic 3x3 board
+#define GRID_SIZE 3    // Number of grids on the classic board, sets the window size
 
 // Game states
 typedef enum { HOME,
@@ -19,10 +16,8 @@ typedef enum { HOME,
                DIFFICULTY_SELECTION,
                ONE_PLAYER } GameState;
 typedef enum { NORMAL,
-               IMPOSSIBLE } Difficulty;
-typedef struct {
-  float Lifetime;
-} Timer;
+               IMPOSSIBLE,
+               MONTE_CARLO } Difficulty;
 
 // Structure to hold game resources
 typedef struct {
@@ -39,7 +34,9 @@ typedef struct {
 typedef struct {
   GameState state;
   Difficulty difficulty;
-  int board[MAX_FEATURES];
+  MnkVariant variant;  // Board size and win length
+  MnkBoard board;
+  int lastMove;  // Cell of the latest move, -1 on an empty board
   int currentPlayer;
   int winner;
   bool gameOver;
@@ -53,16 +50,15 @@ Color DARK_RED = (Color){250, 30, 60, 255};
 
 // function prototypes
 void display_board(GameData *game, GameResources *resources);
-extern int check_winner(int board[9]);  // assembly conversion
 void getMove(GameData *game, Sound clickSound, int *restrictPlayer);
 void declare_winner(GameData *game, bool *gameStartSoundPlayed, int isAI);
 void drawAIStats(int screenWidth);
 void resetGame(GameData *game, bool *gameStartSoundPlayed, int *callOnce);
 void incrementAIWinCount();
-void empty_board(int board[MAX_FEATURES]);
-void StartTimer(Timer *timer, float lifetime);
-void UpdateTimer(Timer *timer);
-bool TimerDone(Timer *timer);
+void empty_board(GameData *game);
+int board_cell_size(MnkVariant variant);
+void play_move(GameData *game, int cell, int player);
+void draw_ai_thinking(void);
 void initializeGame(GameData *game);
 void update_game_state(GameData *gameData, bool *gameStartSoundPlayed);
 
@@ -74,7 +70,7 @@ extern int total_games;
 // to be reused for multiple code files
 int ai_win_count = 0;
 int total_games = 0;
-Timer ai_waitTimer = {0};
+AIWorker aiWorker;  // Computes bot moves off the render thread
 
 void initializeGame(GameData *game) {
   // Set initial game state and parameters
@@ -83,33 +79,47 @@ void initializeGame(GameData *game) {
   game->currentPlayer = X;
   game->winner = EMPTY;
   game->gameOver = false;
-  empty_board(game->board);
+  game->variant = MNK_PRESETS[0];
+  empty_board(game);
+}
+
+// Cells shrink so every board variant fits the classic window
+int board_cell_size(MnkVariant variant) {
+  const int longest = variant.rows > variant.cols ? variant.rows : variant.cols;
+  return CELL_SIZE * GRID_SIZE / longest;
+}
+
+// Place a stone and remember it, win checks only look at lines through it
+void play_move(GameData *game, int cell, int player) {
+  mnk_make_move(game->variant, &game->board, cell, player);
+  game->lastMove = cell;
 }
 
 void display_board(GameData *game, GameResources *resources) {
-  const int PADDING = 35;         // Padding for X symbol
-  const int CIRCLE_PADDING = 5;   // Padding for O symbol
-  const int BOARD_OFFSET_Y = 50;  // Vertical offset for the board
+  const int cellSize = board_cell_size(game->variant);
+  const int PADDING = cellSize * 35 / CELL_SIZE;        // Padding for X symbol
+  const int CIRCLE_PADDING = cellSize * 5 / CELL_SIZE;  // Padding for O symbol
+  const int BOARD_OFFSET_Y = 50;                        // Vertical offset for the board
 
-  for (int row = 0; row < GRID_SIZE; row++) {
-    for (int col = 0; col < GRID_SIZE; col++) {
+  for (int row = 0; row < game->variant.rows; row++) {
+    for (int col = 0; col < game->variant.cols; col++) {
       // Calculate positions
-      int x = col * CELL_SIZE;
-      int y = row * CELL_SIZE + BOARD_OFFSET_Y;
-      int cell = row * GRID_SIZE + col;
+      int x = col * cellSize;
+      int y = row * cellSize + BOARD_OFFSET_Y;
+      int cell = row * game->variant.cols + col;
 
       // Draw grid lines
-      DrawRectangleLines(x, y, CELL_SIZE, CELL_SIZE, OFF_WHITE);
+      DrawRectangleLines(x, y, cellSize, cellSize, OFF_WHITE);
 
       // Draw symbols based on cell state
       Rectangle destRect;
-      switch (game->board[cell]) {
+      switch (mnk_cell(&game->board, cell)) {
         case X:
           destRect = (Rectangle){
               x + PADDING,
               y + PADDING,
-              CELL_SIZE - 2 * PADDING,
-              CELL_SIZE - 2 * PADDING};
+              cellSize - 2 * PADDING,
+              cellSize - 2 * PADDING};
           DrawTexturePro(resources->cross,
                          (Rectangle){0, 0, resources->cross.width, resources->cross.height},
                          destRect, (Vector2){0, 0}, 0.0f, DARK_RED);
@@ -119,8 +129,8 @@ void display_board(GameData *game, GameResources *resources) {
           destRect = (Rectangle){
               x + CIRCLE_PADDING,
               y + CIRCLE_PADDING,
-              CELL_SIZE - 2 * CIRCLE_PADDING,
-              CELL_SIZE - 2 * CIRCLE_PADDING};
+              cellSize - 2 * CIRCLE_PADDING,
+              cellSize - 2 * CIRCLE_PADDING};
           DrawTexturePro(resources->circle,
                          (Rectangle){0, 0, resources->circle.width, resources->circle.height},
                          destRect, (Vector2){0, 0}, 0.0f, DARK_BLUE);
@@ -130,45 +140,6 @@ void display_board(GameData *game, GameResources *resources) {
   }
 }
 
-// run this if environment is x64
-#if defined(_WIN64)
-// Function to check the winner
-int check_winner(int board[MAX_FEATURES]) {
-  // Define winning patterns as static const to ensure they're only created once
-  static const int win_patterns[][3] = {
-      {0, 1, 2}, {3, 4, 5}, {6, 7, 8},  // Rows
-      {0, 3, 6},
-      {1, 4, 7},
-      {2, 5, 8},  // Columns
-      {0, 4, 8},
-      {2, 4, 6}  // Diagonals
-  };
-  static const int NUM_PATTERNS = 8;
-
-  // Check all winning patterns
-  for (int i = 0; i < NUM_PATTERNS; i++) {
-    const int *pattern = win_patterns[i];
-    if (board[pattern[0]] != EMPTY &&
-        board[pattern[0]] == board[pattern[1]] &&
-        board[pattern[1]] == board[pattern[2]]) {
-      return board[pattern[0]];
-    }
-  }
-
-  // Check for tie
-  bool is_tie = true;
-  for (int i = 0; i < MAX_FEATURES; i++) {
-    if (board[i] == EMPTY) {
-      is_tie = false;
-      break;
-    }
-  }
-  if (is_tie) return TIE;
-
-  return EMPTY;  // Game is still ongoing
-}
-#endif
-
 // function to increment AI count
 void incrementAIWinCount() { ai_win_count++; }
 
@@ -193,7 +164,7 @@ void drawAIStats(int screenWidth) {
 }
 
 void resetGame(GameData *game, bool *gameStartSoundPlayed, int *callOnce) {
-  empty_board(game->board);
+  empty_board(game);
   game->currentPlayer = X;
   game->gameOver = false;
   game->winner = EMPTY;
@@ -255,12 +226,14 @@ void declare_winner(GameData *game, bool *gameStartSoundPlayed, int isAI) {
 void getMove(GameData *game, Sound clickSound, int *restrictPlayer) {
   if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && *restrictPlayer == false) {
     Vector2 mousePos = GetMousePosition();
-    int col = mousePos.x / CELL_SIZE;
-    int row = (mousePos.y - 50) / CELL_SIZE;
-    int cell = row * GRID_SIZE + col;
-
-    if (row >= 0 && row < GRID_SIZE && col >= 0 && col < GRID_SIZE && game->board[cell] == EMPTY) {
-      game->board[cell] = game->currentPlayer;
+    const int cellSize = board_cell_size(game->variant);
+    int col = mousePos.x / cellSize;
+    int row = (mousePos.y - 50) / cellSize;
+    int cell = row * game->variant.cols + col;
+
+    if (mousePos.y >= 50 && row < game->variant.rows && col >= 0 && col < game->variant.cols &&
+        mnk_cell(&game->board, cell) == EMPTY) {
+      play_move(game, cell, game->currentPlayer);
       game->currentPlayer = (game->currentPlayer == X) ? O : X;
       PlaySound(clickSound);
     }
@@ -268,32 +241,29 @@ void getMove(GameData *game, Sound clickSound, int *restrictPlayer) {
 }
 
 // Initialize empty board
-void empty_board(int board[MAX_FEATURES]) {
-  for (int i = 0; i < MAX_FEATURES; i++) board[i] = EMPTY;
-}
-
-// Simple Timer system for AI waits, instead of using sleep that may crash
-// program start or restart a timer with a specific lifetime
-void StartTimer(Timer *timer, float lifetime) {
-  if (timer != NULL) timer->Lifetime = lifetime;
-}
-
-// update a timer with the current frame time
-void UpdateTimer(Timer *timer) {
-  // subtract this frame from the timer if it's not already expired
-  if (timer != NULL && timer->Lifetime > 0) timer->Lifetime -= GetFrameTime();
+void empty_board(GameData *game) {
+  mnk_clear(&game->board);
+  game->lastMove = -1;
 }
 
-// check if a timer is done.
-bool TimerDone(Timer *timer) {
-  if (timer != NULL) return timer->Lifetime <= 0;
-
-  return false;
+// Status line shown below the board while the bot's move is being computed
+void draw_ai_thinking(void) {
+  const int screenWidth = CELL_SIZE * GRID_SIZE;
+  const double seconds = (search_now_ms() - aiWorker.startedMs) / 1000.0;
+  const char *status = TextFormat("Depth %d, %llu positions, %.1fs",
+                                  atomic_load(&aiWorker.progress.depth),
+                                  (unsigned long long)atomic_load(&aiWorker.progress.nodes),
+                                  seconds);
+
+  DrawText("Bot is Thinking...", screenWidth / 2 - MeasureText("Bot is Thinking...", 20) / 2,
+           CELL_SIZE * GRID_SIZE + 60, 20, DARK_BLUE);
+  DrawText(status, screenWidth / 2 - MeasureText(status, 20) / 2, CELL_SIZE * GRID_SIZE + 90, 20,
+           OFF_WHITE);
 }
 
 // Helper function to handle game state updates
 void update_game_state(GameData *gameData, bool *gameStartSoundPlayed) {
-  gameData->winner = check_winner(gameData->board);
+  gameData->winner = mnk_check_winner(gameData->variant, &gameData->board, gameData->lastMove);
   if (gameData->winner != EMPTY) {
     gameData->gameOver = true;
     declare_winner(gameData, gameStartSoundPlayed, 1);
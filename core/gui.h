@@ -6,13 +6,14 @@
 #include <time.h>
 
 // Function prototypes
-void home_screen(GameState *gameState, Texture2D TTT_ICON);
+void home_screen(GameState *gameState, MnkVariant *variant, Texture2D TTT_ICON);
 void select_difficulty(GameState *gameState, Difficulty *selectedDifficulty);
 static void draw_menu_button(int x, int y, int width, int height, const char *text);
 static void handle_menu_clicks(GameState *gameState, int buttonX, int buttonY,
                                int buttonY2, int buttonWidth, int buttonHeight);
+static void handle_variant_click(MnkVariant *variant, int x, int y, int width, int height);
 static void handle_difficulty_clicks(GameState *gameState, Difficulty *selectedDifficulty,
-                                     int buttonX, int buttonY, int buttonY2,
+                                     int buttonX, int buttonY, int buttonY2, int buttonY3,
                                      int buttonWidth, int buttonHeight,
                                      int backButtonX, int backButtonY,
                                      int backButtonWidth, int backButtonHeight);
@@ -23,9 +24,10 @@ void unloadResources(GameResources *res);
 /**
  * Draws and handles interactions for the home screen
  * @param gameState Pointer to the current game state
+ * @param variant Board size and win length, cycled by the board button
  * @param TTT_ICON Texture containing the game icon
  */
-void home_screen(GameState *gameState, Texture2D TTT_ICON) {
+void home_screen(GameState *gameState, MnkVariant *variant, Texture2D TTT_ICON) {
   // Calculate screen dimensions
   const int screenWidth = CELL_SIZE * GRID_SIZE;
   const int screenHeight = CELL_SIZE * GRID_SIZE + 100;
@@ -60,8 +62,17 @@ void home_screen(GameState *gameState, Texture2D TTT_ICON) {
   draw_menu_button(buttonX, buttonY, buttonWidth, buttonHeight, "One Player");
   draw_menu_button(buttonX, buttonY2, buttonWidth, buttonHeight, "Two Player");
 
+  // Board variant button, cycles through the presets
+  char boardLabel[48];
+  snprintf(boardLabel, sizeof(boardLabel), "Board: %s", mnk_variant_name(*variant));
+  const int boardButtonWidth = MeasureText(boardLabel, 20) + 20;
+  const int boardButtonX = screenWidth / 2 - boardButtonWidth / 2;
+  const int boardButtonY = buttonY2 + buttonHeight + buttonSpacing;
+  draw_menu_button(boardButtonX, boardButtonY, boardButtonWidth, buttonHeight, boardLabel);
+
   // Handle button clicks
   handle_menu_clicks(gameState, buttonX, buttonY, buttonY2, buttonWidth, buttonHeight);
+  handle_variant_click(variant, boardButtonX, boardButtonY, boardButtonWidth, buttonHeight);
 }
 
 void loadResources(GameResources *res) {
@@ -117,16 +128,18 @@ void select_difficulty(GameState *gameState, Difficulty *selectedDifficulty) {
            screenHeight / 2 - 120, 30, OFF_WHITE);
 
   // Button dimensions
-  const int buttonWidth = MeasureText("IMPOSSIBLE", 20) + 20;
+  const int buttonWidth = MeasureText("Monte Carlo", 20) + 20;
   const int buttonHeight = 40;
   const int buttonSpacing = 20;
   const int buttonX = screenWidth / 2 - buttonWidth / 2;
   const int buttonY = screenHeight / 2 - 40;
   const int buttonY2 = buttonY + buttonHeight + buttonSpacing;
+  const int buttonY3 = buttonY2 + buttonHeight + buttonSpacing;
 
   // Draw difficulty buttons
   draw_menu_button(buttonX, buttonY, buttonWidth, buttonHeight, "Normal");
   draw_menu_button(buttonX, buttonY2, buttonWidth, buttonHeight, "Impossible");
+  draw_menu_button(buttonX, buttonY3, buttonWidth, buttonHeight, "Monte Carlo");
 
   // Draw back button
   const int backButtonWidth = MeasureText("Back", 20) + 20;
@@ -136,7 +149,7 @@ void select_difficulty(GameState *gameState, Difficulty *selectedDifficulty) {
   draw_menu_button(backButtonX, backButtonY, backButtonWidth, backButtonHeight, "Back");
 
   // Handle button interactions
-  handle_difficulty_clicks(gameState, selectedDifficulty, buttonX, buttonY, buttonY2,
+  handle_difficulty_clicks(gameState, selectedDifficulty, buttonX, buttonY, buttonY2, buttonY3,
                            buttonWidth, buttonHeight, backButtonX, backButtonY,
                            backButtonWidth, backButtonHeight);
 }
@@ -166,11 +179,31 @@ static void handle_menu_clicks(GameState *gameState, int buttonX, int buttonY,
   }
 }
 
+/**
+ * Helper function to switch to the next board preset when its button is clicked
+ */
+static void handle_variant_click(MnkVariant *variant, int x, int y, int width, int height) {
+  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    Vector2 mousePos = GetMousePosition();
+    if (mousePos.x >= x && mousePos.x <= x + width && mousePos.y >= y && mousePos.y <= y + height) {
+      int next = 0;
+      for (int i = 0; i < MNK_NUM_PRESETS; i++) {
+        const MnkVariant preset = MNK_PRESETS[i];
+        if (preset.rows == variant->rows && preset.cols == variant->cols &&
+            preset.k == variant->k) {
+          next = (i + 1) % MNK_NUM_PRESETS;
+        }
+      }
+      *variant = MNK_PRESETS[next];
+    }
+  }
+}
+
 /**
  * Helper function to handle difficulty selection clicks
  */
 static void handle_difficulty_clicks(GameState *gameState, Difficulty *selectedDifficulty,
-                                     int buttonX, int buttonY, int buttonY2,
+                                     int buttonX, int buttonY, int buttonY2, int buttonY3,
                                      int buttonWidth, int buttonHeight,
                                      int backButtonX, int backButtonY,
                                      int backButtonWidth, int backButtonHeight) {
@@ -183,6 +216,9 @@ static void handle_difficulty_clicks(GameState *gameState, Difficulty *selectedD
       } else if (mousePos.y >= buttonY2 && mousePos.y <= buttonY2 + buttonHeight) {
         *selectedDifficulty = IMPOSSIBLE;
         *gameState = ONE_PLAYER;
+      } else if (mousePos.y >= buttonY3 && mousePos.y <= buttonY3 + buttonHeight) {
+        *selectedDifficulty = MONTE_CARLO;
+        *gameState = ONE_PLAYER;
       }
     }
     // Handle back button
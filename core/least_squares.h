@@ -0,0 +1,122 @@
+#ifndef LEAST_SQUARES_H
+#define LEAST_SQUARES_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Closed-form linear regression through the normal equations
+// (X^T X) w = X^T y, where X has a trailing column of ones for the bias.
+// Samples are added one at a time into fixed size sums, so a fit takes one
+// pass over the data and no copy of it. Threads can each sum their own run
+// of samples and merge the sums afterwards. Features and labels are small
+// integers, so the sums are kept exactly in 64 bits and the result does not
+// depend on the order samples arrive in or how they were split.
+#define LS_MAX_FEATURES 32
+#define LS_RIDGE 1e-9  // Per sample diagonal term, keeps a constant feature from breaking the solve
+
+typedef struct {
+  int featureCount;
+  long long count;  // Samples added
+  int64_t xtx[LS_MAX_FEATURES + 1][LS_MAX_FEATURES + 1];  // Upper triangle is used
+  int64_t xty[LS_MAX_FEATURES + 1];
+  int64_t yty;  // Sum of squared labels, for the training error
+} LeastSquares;
+
+// function prototypes
+void least_squares_init(LeastSquares *ls, int featureCount);
+void least_squares_add(LeastSquares *ls, const int8_t *features, int label);
+void least_squares_merge(LeastSquares *into, const LeastSquares *from);
+bool least_squares_solve(const LeastSquares *ls, double *weights);
+double least_squares_mse(const LeastSquares *ls, const double *weights);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+void least_squares_init(LeastSquares *ls, int featureCount) {
+  memset(ls, 0, sizeof(*ls));
+  ls->featureCount = featureCount < LS_MAX_FEATURES ? featureCount : LS_MAX_FEATURES;
+}
+
+// Add one sample's outer product to the running sums
+void least_squares_add(LeastSquares *ls, const int8_t *features, int label) {
+  const int n = ls->featureCount;
+  int row[LS_MAX_FEATURES + 1];
+  for (int i = 0; i < n; i++) row[i] = features[i];
+  row[n] = 1;  // Bias column
+
+  for (int i = 0; i <= n; i++) {
+    if (row[i] == 0) continue;  // Empty cells add nothing
+    for (int j = i; j <= n; j++) ls->xtx[i][j] += row[i] * row[j];
+    ls->xty[i] += row[i] * label;
+  }
+  ls->yty += (int64_t)label * label;
+  ls->count++;
+}
+
+// Combine sums built separately, e.g. one per thread
+void least_squares_merge(LeastSquares *into, const LeastSquares *from) {
+  const int n = into->featureCount;
+  for (int i = 0; i <= n; i++) {
+    for (int j = i; j <= n; j++) into->xtx[i][j] += from->xtx[i][j];
+    into->xty[i] += from->xty[i];
+  }
+  into->yty += from->yty;
+  into->count += from->count;
+}
+
+// Solve the normal equations by Cholesky decomposition. weights receives
+// featureCount weights followed by the bias. Returns false when there are
+// too few samples for the system to have a unique solution
+bool least_squares_solve(const LeastSquares *ls, double *weights) {
+  const int size = ls->featureCount + 1;
+  double l[LS_MAX_FEATURES + 1][LS_MAX_FEATURES + 1] = {{0}};
+
+  // X^T X = L L^T, reading the symmetric matrix from its upper triangle
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j <= i; j++) {
+      double sum = (double)ls->xtx[j][i];
+      if (i == j) sum += LS_RIDGE * (ls->count > 0 ? ls->count : 1);
+      for (int k = 0; k < j; k++) sum -= l[i][k] * l[j][k];
+      if (i == j) {
+        if (sum <= 0) return false;
+        l[i][i] = sqrt(sum);
+      } else {
+        l[i][j] = sum / l[j][j];
+      }
+    }
+  }
+
+  // Forward substitution L z = X^T y, then back substitution L^T w = z
+  double z[LS_MAX_FEATURES + 1];
+  for (int i = 0; i < size; i++) {
+    double sum = (double)ls->xty[i];
+    for (int k = 0; k < i; k++) sum -= l[i][k] * z[k];
+    z[i] = sum / l[i][i];
+  }
+  for (int i = size - 1; i >= 0; i--) {
+    double sum = z[i];
+    for (int k = i + 1; k < size; k++) sum -= l[k][i] * weights[k];
+    weights[i] = sum / l[i][i];
+  }
+  return true;
+}
+
+// Mean squared training error of weights, straight from the sums:
+// |Xw - y|^2 = w^T (X^T X) w - 2 w^T (X^T y) + y^T y
+double least_squares_mse(const LeastSquares *ls, const double *weights) {
+  const int size = ls->featureCount + 1;
+  double sse = (double)ls->yty;
+  for (int i = 0; i < size; i++) {
+    sse -= 2 * weights[i] * ls->xty[i];
+    for (int j = 0; j < size; j++) {
+      const int64_t xtx = i <= j ? ls->xtx[i][j] : ls->xtx[j][i];
+      sse += weights[i] * xtx * weights[j];
+    }
+  }
+  return ls->count > 0 ? sse / ls->count : 0;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Read-only view of a whole file, mapped into memory (mmap, or
+// MapViewOfFile on Windows). The OS pages the file in as it is read, so
+// multi-gigabyte datasets are parsed in place instead of being copied onto
+// the heap first, and the pages can be dropped again under memory pressure
+typedef struct {
+  const char *data;  // NULL for an empty file
+  size_t size;
+#if defined(_WIN32)
+  void *file;     // HANDLEs, windows.h stays out of this header as it clashes with raylib.h
+  void *mapping;
+#endif
+} MappedFile;
+
+// function prototypes
+bool mapped_file_open(const char *filename, MappedFile *file);
+void mapped_file_close(MappedFile *file);
+void mapped_file_release(const MappedFile *file, size_t begin, size_t end);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+#if defined(_WIN32)
+#include <windows.h>
+
+// Map filename for reading, false when it cannot be opened or mapped
+bool mapped_file_open(const char *filename, MappedFile *file) {
+  file->data = NULL;
+  file->size = 0;
+  file->mapping = NULL;
+  file->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file->file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx((HANDLE)file->file, &size)) {
+    CloseHandle((HANDLE)file->file);
+    return false;
+  }
+  file->size = (size_t)size.QuadPart;
+  if (file->size == 0) return true;  // Nothing to map
+
+  file->mapping = CreateFileMappingA((HANDLE)file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (file->mapping != NULL) {
+    file->data = MapViewOfFile((HANDLE)file->mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (file->data == NULL) {
+    mapped_file_close(file);
+    return false;
+  }
+  return true;
+}
+
+void mapped_file_close(MappedFile *file) {
+  if (file->data != NULL) UnmapViewOfFile(file->data);
+  if (file->mapping != NULL) CloseHandle((HANDLE)file->mapping);
+  if (file->file != INVALID_HANDLE_VALUE) CloseHandle((HANDLE)file->file);
+  file->data = NULL;
+  file->size = 0;
+  file->mapping = NULL;
+  file->file = INVALID_HANDLE_VALUE;
+}
+
+// Windows trims the working set of mapped files by itself
+void mapped_file_release(const MappedFile *file, size_t begin, size_t end) {
+  (void)file;
+  (void)begin;
+  (void)end;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Map filename for reading, false when it cannot be opened or mapped
+bool mapped_file_open(const char *filename, MappedFile *file) {
+  file->data = NULL;
+  file->size = 0;
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return false;
+  }
+  file->size = (size_t)info.st_size;
+  if (file->size == 0) {  // mmap refuses empty files
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping keeps the file open
+  if (data == MAP_FAILED) {
+    file->size = 0;
+    return false;
+  }
+  madvise(data, file->size, MADV_SEQUENTIAL);  // Read ahead, drop pages behind
+  file->data = data;
+  return true;
+}
+
+void mapped_file_close(MappedFile *file) {
+  if (file->data != NULL) munmap((void *)file->data, file->size);
+  file->data = NULL;
+  file->size = 0;
+}
+
+// Drop the whole pages inside [begin, end) from this process once they have
+// been read, so scanning a file larger than memory keeps a bounded resident
+// size. Touching them again reads them back from the page cache
+void mapped_file_release(const MappedFile *file, size_t begin, size_t end) {
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  begin = (begin + page - 1) / page * page;
+  end = end / page * page;
+  if (file->data != NULL && begin < end) {
+    madvise((void *)(file->data + begin), end - begin, MADV_DONTNEED);
+  }
+}
+
+#endif
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
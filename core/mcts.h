@@ -0,0 +1,56 @@
+#include "mcts_engine.h"
+
+// Function prototypes
+void mctsAI(GameData *gameData, GameResources *resources);
+
+MctsTree mctsTree;  // Kept between moves so each search continues the last one
+
+// Handle game play between human and the Monte Carlo tree search bot
+void mctsAI(GameData *gameData, GameResources *resources) {
+  static bool gameStartSoundPlayed = false;
+  static int restrictPlayer = false;
+
+  if (!gameStartSoundPlayed) {
+    PlaySound(resources->gameStart);
+    gameStartSoundPlayed = true;
+  }
+
+  DrawText("Player 1 [X]", 10, 20, 20, DARK_RED);
+  DrawText("Bot [O]", GetScreenWidth() - 130, 20, 20, DARK_BLUE);
+
+  if (gameData->gameOver) {
+    restrictPlayer = false;
+    declare_winner(gameData, &gameStartSoundPlayed, 1);
+    return;
+  }
+
+  display_board(gameData, resources);
+  getMove(gameData, resources->clickSound, &restrictPlayer);
+
+  // Bot's turn, skipped when the player's move already ended the game
+  if (gameData->currentPlayer == O &&
+      mnk_check_winner(gameData->variant, &gameData->board, gameData->lastMove) == EMPTY) {
+    // Hand the position to the worker and keep drawing until it answers
+    if (!restrictPlayer) {
+      AIJob job = {mcts_ai_job, gameData->variant, gameData->board, O, &mctsTree};
+      restrictPlayer = ai_worker_submit(&aiWorker, &job);
+    }
+
+    SearchResult result;
+    if (restrictPlayer && ai_worker_poll(&aiWorker, &result)) {
+      if (DEBUG) {
+        printf("\nMCTS: %llu playouts, %d reused, depth %d, win rate %.1f%%", result.nodes,
+               mctsTree.reusedVisits, result.depth, result.bestScore / 10.0);
+      }
+      if (result.bestMove != -1) {
+        play_move(gameData, result.bestMove, O);
+      }
+      gameData->currentPlayer = X;
+      restrictPlayer = false;
+    } else {
+      draw_ai_thinking();
+    }
+  }
+
+  update_game_state(gameData, &gameStartSoundPlayed);
+}
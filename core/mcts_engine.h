@@ -0,0 +1,372 @@
+#ifndef MCTS_ENGINE_H
+#define MCTS_ENGINE_H
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aiworker.h"
+#include "mnk.h"
+#include "search.h"
+#include "threadpool.h"
+
+// Monte Carlo tree search (UCT) for m,n,k boards, the engine behind the
+// MONTE_CARLO bot. Every playout walks down the tree by UCT, grows it by
+// one node's children and finishes the game with random moves; the move
+// played is the root child with the most visits.
+//
+// Tree parallel: the search threads share one tree. Node statistics are
+// atomics, and a thread walking through a node adds a virtual loss to it
+// until its playout is backed up, steering the other threads to different
+// lines. Whichever thread first claims a leaf expands it, the others
+// play out from it meanwhile.
+//
+// Tree reuse: the tree is kept between moves. When the next position
+// follows from the root by moves the tree already has, that subtree is
+// copied into the spare pool and becomes the new root, visits included.
+#define MCTS_PLAYOUTS 20000        // Default budget per move
+#define MCTS_MAX_NODES (1 << 19)   // Per pool, expansion stops once it is full
+#define MCTS_EXPLORATION 1.0       // UCT constant, rewards are in [0, 1]
+#define MCTS_EXPAND_VISITS 2       // Visits a leaf needs before it grows children
+#define MCTS_MAX_PLIES 3           // Deepest reuse, in plies from the old root
+
+typedef enum { MCTS_LEAF,
+               MCTS_EXPANDING,
+               MCTS_EXPANDED } MctsNodeState;
+
+typedef struct {
+  int32_t firstChild;  // Children are contiguous, valid once state is MCTS_EXPANDED
+  int16_t childCount;
+  int16_t move;        // Cell played to reach this node, -1 at the root
+  int8_t outcome;      // EMPTY, or X, O or TIE when move ended the game
+  atomic_int state;
+  atomic_int visits;
+  atomic_int reward;       // Twice the points of the side that played move
+  atomic_int virtualLoss;  // Playouts currently passing through
+} MctsNode;
+
+typedef struct {
+  MctsNode *nodes;  // nodes[0] is the root
+  MctsNode *spare;  // Reuse copies the kept subtree here, then the pools swap
+  atomic_int used;
+  MnkVariant variant;
+  MnkBoard root;    // Position at nodes[0]
+  int rootPlayer;   // Side to move there
+  bool ready;       // Whether nodes holds a tree for root
+  int playouts;     // Budget per search, 0 for MCTS_PLAYOUTS
+  int reusedVisits; // Root visits kept by the last search
+  atomic_int maxDepth;
+} MctsTree;
+
+// function prototypes
+void mcts_free(MctsTree *tree);
+SearchResult mcts_search(MctsTree *tree, MnkVariant variant, const MnkBoard *board, int player,
+                         int playouts, SearchProgress *progress);
+SearchResult mcts_ai_job(const AIJob *job, SearchProgress *progress);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+void mcts_free(MctsTree *tree) {
+  free(tree->nodes);
+  free(tree->spare);
+  tree->nodes = tree->spare = NULL;
+  tree->ready = false;
+}
+
+static void mcts_node_init(MctsNode *node, int move, int outcome) {
+  node->firstChild = -1;
+  node->childCount = 0;
+  node->move = (int16_t)move;
+  node->outcome = (int8_t)outcome;
+  atomic_init(&node->state, MCTS_LEAF);
+  atomic_init(&node->visits, 0);
+  atomic_init(&node->reward, 0);
+  atomic_init(&node->virtualLoss, 0);
+}
+
+// splitmix64 step, one stream per thread
+static uint64_t mcts_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Give node a child per candidate move of player, false when the pool is full
+static bool mcts_expand(MctsTree *tree, MctsNode *node, MnkBoard *board, int player) {
+  int moves[MNK_MAX_CELLS];
+  const int count = mnk_candidate_moves(tree->variant, board, moves);
+  if (atomic_load(&tree->used) + count > MCTS_MAX_NODES) return false;
+  const int first = atomic_fetch_add(&tree->used, count);
+  if (first + count > MCTS_MAX_NODES) return false;  // Another thread got there first
+
+  for (int i = 0; i < count; i++) {
+    mnk_make_move(tree->variant, board, moves[i], player);
+    int outcome = mnk_check_winner(tree->variant, board, moves[i]);
+    mnk_unmake_move(tree->variant, board, moves[i]);
+    mcts_node_init(&tree->nodes[first + i], moves[i], outcome);
+  }
+  node->firstChild = first;
+  node->childCount = (int16_t)count;
+  return true;
+}
+
+// UCT child of an expanded node, virtual losses counted as lost playouts
+static int mcts_select(const MctsTree *tree, const MctsNode *node) {
+  const int parentVisits = atomic_load(&node->visits) + atomic_load(&node->virtualLoss);
+  const double logVisits = log(parentVisits > 1 ? parentVisits : 1);
+  int best = node->firstChild;
+  double bestValue = -1;
+
+  for (int i = node->firstChild; i < node->firstChild + node->childCount; i++) {
+    const MctsNode *child = &tree->nodes[i];
+    const int visits = atomic_load(&child->visits) + atomic_load(&child->virtualLoss);
+    if (visits == 0) return i;  // Every child is tried once first
+    const double value = atomic_load(&child->reward) / (2.0 * visits) +
+                         MCTS_EXPLORATION * sqrt(logVisits / visits);
+    if (value > bestValue) {
+      bestValue = value;
+      best = i;
+    }
+  }
+  return best;
+}
+
+// Finish the game with random moves, player to move. Returns X, O or TIE
+static int mcts_playout(MnkVariant variant, MnkBoard *board, int player, uint64_t *rng) {
+  int empty[MNK_MAX_CELLS];
+  int count = 0;
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t cells = mnk_empty_word(variant, board, w);
+    while (cells) empty[count++] = mnk_pop_lsb(&cells, w);
+  }
+
+  while (count > 0) {
+    const int pick = (int)(mcts_random(rng) % count);
+    const int cell = empty[pick];
+    empty[pick] = empty[--count];
+    mnk_make_move(variant, board, cell, player);
+    if (mnk_is_win_at(variant, board, cell)) return player;
+    player = -player;
+  }
+  return TIE;
+}
+
+// One playout: select, expand, simulate, back up
+static void mcts_iterate(MctsTree *tree, uint64_t *rng) {
+  int path[MNK_MAX_CELLS + 1];
+  int depth = 0;
+  MnkBoard board = tree->root;
+  int player = tree->rootPlayer;
+  int index = 0;
+  int outcome = EMPTY;
+  path[0] = 0;
+
+  while (true) {
+    MctsNode *node = &tree->nodes[index];
+    if (node->outcome != EMPTY) {
+      outcome = node->outcome;
+      break;
+    }
+
+    int state = atomic_load(&node->state);
+    if (state == MCTS_LEAF && atomic_load(&node->visits) + 1 >= MCTS_EXPAND_VISITS) {
+      int expected = MCTS_LEAF;
+      if (atomic_compare_exchange_strong(&node->state, &expected, MCTS_EXPANDING)) {
+        state = mcts_expand(tree, node, &board, player) ? MCTS_EXPANDED : MCTS_LEAF;
+        atomic_store(&node->state, state);
+      }
+    }
+    if (state != MCTS_EXPANDED) break;
+
+    index = mcts_select(tree, node);
+    atomic_fetch_add(&tree->nodes[index].virtualLoss, 1);
+    path[++depth] = index;
+    mnk_make_move(tree->variant, &board, tree->nodes[index].move, player);
+    player = -player;
+  }
+
+  if (outcome == EMPTY) outcome = mcts_playout(tree->variant, &board, player, rng);
+  int deepest = atomic_load(&tree->maxDepth);
+  while (depth > deepest && !atomic_compare_exchange_weak(&tree->maxDepth, &deepest, depth)) {
+  }
+
+  // The node at depth d was reached by a move of rootPlayer when d is odd
+  for (int d = depth; d >= 0; d--) {
+    MctsNode *node = &tree->nodes[path[d]];
+    const int mover = d % 2 == 1 ? tree->rootPlayer : -tree->rootPlayer;
+    atomic_fetch_add(&node->visits, 1);
+    atomic_fetch_add(&node->reward, outcome == TIE ? 1 : outcome == mover ? 2 : 0);
+    if (d > 0) atomic_fetch_sub(&node->virtualLoss, 1);
+  }
+}
+
+typedef struct {
+  MctsTree *tree;
+  int playouts;
+  atomic_int started;
+  SearchProgress *progress;
+  uint64_t seed;
+} MctsSplit;
+
+static void mcts_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  MctsSplit *split = (MctsSplit *)arg;
+  uint64_t rng = split->seed + (uint64_t)thread * 0xD1B54A32D192ED03ULL;
+  int done = 0;
+
+  while (atomic_fetch_add(&split->started, 1) < split->playouts) {
+    mcts_iterate(split->tree, &rng);
+
+    // Publish progress and check for cancellation every few playouts
+    if (++done % 64 == 0 && split->progress != NULL) {
+      atomic_fetch_add(&split->progress->nodes, 64);
+      atomic_store(&split->progress->depth, atomic_load(&split->tree->maxDepth));
+      if (atomic_load(&split->progress->cancel)) break;
+    }
+  }
+}
+
+// Copy the subtree under index into the spare pool as its root, then swap pools
+static void mcts_reroot(MctsTree *tree, int index) {
+  MctsNode *from = tree->nodes, *to = tree->spare;
+  int *queue = malloc(sizeof(int) * MCTS_MAX_NODES);  // Old index of each copied node
+  if (queue == NULL) {
+    tree->ready = false;
+    return;
+  }
+
+  int used = 1;
+  queue[0] = index;
+  mcts_node_init(&to[0], -1, EMPTY);
+  for (int n = 0; n < used; n++) {
+    const MctsNode *old = &from[queue[n]];
+    MctsNode *copy = &to[n];
+    if (n > 0) mcts_node_init(copy, old->move, old->outcome);
+    atomic_store(&copy->visits, atomic_load(&old->visits));
+    atomic_store(&copy->reward, atomic_load(&old->reward));
+    if (atomic_load(&old->state) != MCTS_EXPANDED) continue;
+
+    copy->firstChild = used;
+    copy->childCount = old->childCount;
+    atomic_store(&copy->state, MCTS_EXPANDED);
+    for (int c = 0; c < old->childCount; c++) queue[used++] = old->firstChild + c;
+  }
+  free(queue);
+
+  tree->nodes = to;
+  tree->spare = from;
+  atomic_store(&tree->used, used);
+}
+
+// Node of the tree holding board, -1 when board does not follow from the
+// root by moves already in the tree
+static int mcts_find(const MctsTree *tree, MnkVariant variant, const MnkBoard *board, int player) {
+  if (!tree->ready || memcmp(&variant, &tree->variant, sizeof(variant)) != 0) return -1;
+  const int plies = board->moves - tree->root.moves;
+  if (plies < 0 || plies > MCTS_MAX_PLIES || (plies % 2 == 0) != (player == tree->rootPlayer)) {
+    return -1;
+  }
+  for (int w = 0; w < MNK_WORDS; w++) {
+    if ((tree->root.x[w] & ~board->x[w]) || (tree->root.o[w] & ~board->o[w])) return -1;
+  }
+
+  // Follow the stones board has on top of the root, one ply at a time
+  int index = 0;
+  int mover = tree->rootPlayer;
+  for (int p = 0; p < plies; p++, mover = -mover) {
+    const MctsNode *node = &tree->nodes[index];
+    if (atomic_load(&node->state) != MCTS_EXPANDED) return -1;
+    int next = -1;
+    for (int c = node->firstChild; c < node->firstChild + node->childCount && next < 0; c++) {
+      const int move = tree->nodes[c].move;
+      if (mnk_cell(board, move) == mover && mnk_cell(&tree->root, move) == EMPTY) next = c;
+    }
+    if (next < 0) return -1;
+    index = next;
+  }
+  return index;
+}
+
+// Search board, player to move, with playouts playouts on the search
+// threads, continuing from the tree of the previous search when board
+// follows from it
+SearchResult mcts_search(MctsTree *tree, MnkVariant variant, const MnkBoard *board, int player,
+                         int playouts, SearchProgress *progress) {
+  SearchResult result = {-1, -SEARCH_INF, -1, -SEARCH_INF, 0, 0};
+  if (mnk_is_full(variant, board)) return result;
+  if (tree->nodes == NULL) {
+    tree->nodes = malloc(sizeof(MctsNode) * MCTS_MAX_NODES);
+    tree->spare = malloc(sizeof(MctsNode) * MCTS_MAX_NODES);
+    tree->ready = false;
+    if (tree->nodes == NULL || tree->spare == NULL) {
+      mcts_free(tree);
+      return result;
+    }
+  }
+
+  const int found = mcts_find(tree, variant, board, player);
+  if (found > 0) mcts_reroot(tree, found);
+  if (found < 0 || !tree->ready) {
+    mcts_node_init(&tree->nodes[0], -1, EMPTY);
+    atomic_store(&tree->used, 1);
+  }
+  tree->variant = variant;
+  tree->root = *board;
+  tree->rootPlayer = player;
+  tree->ready = true;
+  tree->reusedVisits = atomic_load(&tree->nodes[0].visits);
+  atomic_store(&tree->maxDepth, 0);
+
+  MctsSplit split = {tree, playouts, 0, progress, (uint64_t)board->moves * 0x9E3779B97F4A7C15ULL};
+  split.seed ^= (uint64_t)tree->reusedVisits;
+  ThreadPool *pool = search_pool();
+  if (pool != NULL)
+    threadpool_run(pool, mcts_task, &split);
+  else
+    mcts_task(&split, 0, 1);
+  // The pool may be full, playouts never grow the used count past it for long
+  if (atomic_load(&tree->used) > MCTS_MAX_NODES) atomic_store(&tree->used, MCTS_MAX_NODES);
+
+  // Most visited child first, its win rate in per mille as the score
+  const MctsNode *root = &tree->nodes[0];
+  int bestVisits = -1, secondVisits = -1;
+  for (int i = 0; atomic_load(&root->state) == MCTS_EXPANDED && i < root->childCount; i++) {
+    const MctsNode *child = &tree->nodes[root->firstChild + i];
+    const int visits = atomic_load(&child->visits);
+    const int score = visits ? (int)(500LL * atomic_load(&child->reward) / visits) : 0;
+    if (visits > bestVisits) {
+      result.secondMove = result.bestMove;
+      result.secondScore = result.bestScore;
+      secondVisits = bestVisits;
+      result.bestMove = child->move;
+      result.bestScore = score;
+      bestVisits = visits;
+    } else if (visits > secondVisits) {
+      result.secondMove = child->move;
+      result.secondScore = score;
+      secondVisits = visits;
+    }
+  }
+  result.depth = atomic_load(&tree->maxDepth);
+  const int started = atomic_load(&split.started);
+  result.nodes = (unsigned long long)(started < playouts ? started : playouts);
+  if (progress != NULL) atomic_store(&progress->depth, result.depth);
+  return result;
+}
+
+// Worker job for the MONTE_CARLO bot, job->engine holds the MctsTree. Only
+// the worker thread touches the tree, so it is kept between moves
+SearchResult mcts_ai_job(const AIJob *job, SearchProgress *progress) {
+  MctsTree *tree = (MctsTree *)job->engine;
+  MnkBoard board = job->board;
+  return mcts_search(tree, job->variant, &board, job->player,
+                     tree->playouts > 0 ? tree->playouts : MCTS_PLAYOUTS, progress);
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
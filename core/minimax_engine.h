@@ -0,0 +1,74 @@
+#ifndef MINIMAX_ENGINE_H
+#define MINIMAX_ENGINE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aiworker.h"
+#include "bitboard.h"
+#include "retro.h"
+#include "search.h"
+#include "solver.h"
+
+#ifndef DEBUG
+#define DEBUG 1
+#endif
+
+// Engines behind the IMPOSSIBLE bot: the perfect-play table roots and the
+// background worker job
+
+// function prototypes (for game)
+int getRandom(int min, int max);
+
+SearchResult mm_table_root(Bitboard board);
+SearchResult mm_ai_job(const AIJob *job, SearchProgress *progress);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+int getRandom(int min, int max) { return rand() % (max - min + 1) + min; }
+
+// Score the side to move's moves on the classic board by looking up each
+// reply position in the perfect-play table, negated since the opponent is
+// to move there
+SearchResult mm_table_root(Bitboard board) {
+  SearchResult result = {-1, -SEARCH_INF, -1, -SEARCH_INF, 0};
+  const int player = solver_side_to_move(board);
+
+  BBMask moves = bb_empty(board);
+  while (moves) {
+    int i = bb_pop_lsb(&moves);
+    bb_make_move(&board, i, player);  // Simulate move
+    int score = -solver_score(board);
+    if (DEBUG && aiLog) printf("Score for %d is %d\n", i, score);
+    bb_unmake_move(&board, i);  // Revert move
+
+    if (score > result.bestScore) {
+      result.secondMove = result.bestMove;
+      result.secondScore = result.bestScore;
+      result.bestMove = i;
+      result.bestScore = score;
+    } else if (score > result.secondScore) {
+      result.secondMove = i;
+      result.secondScore = score;
+    }
+  }
+  return result;
+}
+
+// Worker job for the IMPOSSIBLE bot: a table lookup on the classic board and
+// on the variant of the --retro table, otherwise a timed iterative deepening search
+SearchResult mm_ai_job(const AIJob *job, SearchProgress *progress) {
+  if (mnk_is_classic(job->variant)) return mm_table_root(mnk_to_bitboard(&job->board));
+  if (retro_covers(&retroTable, job->variant)) {
+    return retro_root(&retroTable, &job->board, job->player);
+  }
+
+  MnkBoard board = job->board;
+  return search_iterative(job->variant, &board, job->player, SEARCH_BUDGET_MS, MNK_MAX_CELLS,
+                          progress);
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,1213 @@
+#ifndef ML_ENGINE_H
+#define ML_ENGINE_H
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "aiworker.h"
+#include "bitboard.h"
+#include "least_squares.h"
+#include "mapped_file.h"
+#include "ml_batch.h"
+#include "mlp.h"
+#include "mnk.h"
+#include "packed_dataset.h"
+#include "search.h"
+#include "threadpool.h"
+#include "train_kernel.h"
+
+// Linear regression model for the NORMAL bot: training on the dataset,
+// evaluation metrics and move inference. No window or audio needed
+#define MAX_FEATURES 9        // Number of features (board positions)
+#define LEARNING_RATE 0.01    // Learning rate for gradient descent
+#define EPOCHS 1000          // Number of training iterations
+#define MSE_THRESHOLD 0.05    // Maximum allowed mean squared error for imperfection
+#define FORGETFULNESS 0.05     // Forgetfulness factor for AI player
+#define MOMENTUM 0.9          // Velocity kept between momentum updates
+#define ADAM_BETA1 0.9        // Adam first moment decay
+#define ADAM_BETA2 0.999      // Adam second moment decay
+#define ADAM_EPSILON 1e-8
+#define DATASET_FILE "./core/dataset/tic-tac-toe.data"
+#define DATASET_PACKED_FILE "./core/dataset/tic-tac-toe.bin"  // make pack-dataset, used when newer
+#define DATASET_SPLIT_BYTES (1 << 20)   // Bytes per loading thread, smaller files load on one
+#define NORMAL_SPLIT_SAMPLES (1 << 16)  // Closed-form training sets this small sum on one thread
+#define MODEL_CACHE_FILE "./model.bin"  // Trained model reused by the next launch
+#define MODEL_CACHE_MAGIC 0x4D545454u   // "TTTM"
+#define MODEL_CACHE_VERSION 2           // Bump when ModelCache or the model changes
+
+// Weight update rule used by train_linear_regression
+typedef enum { OPTIMIZER_GD,        // Full-batch gradient descent
+               OPTIMIZER_SGD,       // Mini-batch stochastic gradient descent
+               OPTIMIZER_MOMENTUM,  // Mini-batch SGD with momentum
+               OPTIMIZER_ADAM,
+               OPTIMIZER_NORMAL } Optimizer;  // Closed-form least squares, one pass
+#define NUM_OPTIMIZERS (OPTIMIZER_NORMAL + 1)
+
+// Model the NORMAL bot plays with
+typedef enum { MODEL_LINEAR,           // Linear regression, trained with config's optimizer
+               MODEL_MLP } ModelKind;  // Small neural network served in int8, see mlp.h
+#define NUM_MODEL_KINDS (MODEL_MLP + 1)
+
+// Why load_data failed
+typedef enum { DATASET_OK,
+               DATASET_OPEN_FAILED,  // Missing or unreadable file
+               DATASET_NO_MEMORY,
+               DATASET_BAD_ROW,       // A line is not 9 cells and a label
+               DATASET_BAD_HEADER,    // Packed file of another version, board or size
+               DATASET_BAD_CHECKSUM } DatasetStatus;  // Packed rows do not match the header
+
+typedef struct {
+  DatasetStatus status;
+  long long line;  // First malformed line (row for packed files, from 1) for DATASET_BAD_ROW
+} DatasetError;
+
+// Training settings, train_config() gives tuned values per optimizer
+typedef struct {
+  Optimizer optimizer;
+  double learningRate;
+  int batchSize;    // Samples per update, 0 for the whole training set
+  int maxEpochs;
+  int patience;     // Epochs without improvement before stopping, 0 never stops early
+  double minDelta;  // Smallest drop in training MSE that counts as improvement
+} TrainConfig;
+
+// Common data structure for machine learning model. The dataset is held
+// once, on the heap, and grows with the file. After shuffling, rows
+// [0, trainSize) are the training set and the rest the test set
+typedef struct {
+  int8_t *features;                               // sampleCount rows of MAX_FEATURES cells
+  int8_t *labels;                                 // Target labels
+  int capacity;                                   // Rows allocated
+  double weights[MAX_FEATURES + 1];               // Model weights + bias term
+  int sampleCount;                                // Number of samples loaded
+  double trainSplit;                              // Train/test split ratio
+  int trainSize;                                  // Size of training set
+  int testSize;                                   // Size of test set
+
+  // Model evaluation metrics
+  int truePositives;      // Correctly predicted positive cases
+  int trueNegatives;      // Correctly predicted negative cases
+  int falsePositives;     // Incorrectly predicted positive cases
+  int falseNegatives;     // Incorrectly predicted negative cases
+  double precision;       // Precision metric
+  double recall;          // Recall metric
+  double f1Score;         // F1 score
+  double errorRate;       // Classification error rate
+
+  // Training settings and outcome
+  ModelKind kind;         // Model ml_init trains and the bot plays with
+  Mlp mlp;                // Trained network when kind is MODEL_MLP
+  MlpInt8 mlpInt8;        // Its int8 copy used for inference
+  TrainConfig config;     // Optimizer, batch size and stopping rule
+  int epochsRun;          // Epochs the last training ran for
+  double finalLoss;       // Training MSE of the last epoch
+} MLModel;
+
+// Model cache file layout. The key fields must all match the current
+// dataset and settings for the cached model to be used, otherwise ml_init
+// trains again and overwrites the file. The file is only read back on the
+// machine that wrote it, so the struct is written as is
+typedef struct {
+  // Key
+  uint32_t magic;
+  uint32_t version;
+  uint32_t featureCount;
+  uint32_t optimizer;
+  uint32_t kind;
+  uint32_t reserved;     // 0, keeps datasetHash 8 byte aligned
+  uint64_t datasetHash;  // FNV-1a of the dataset file
+  double trainSplit;
+  double learningRate;
+  int32_t batchSize;
+  int32_t maxEpochs;
+  int32_t patience;
+  double minDelta;
+
+  // Trained model and its test metrics
+  double weights[MAX_FEATURES + 1];
+  Mlp mlp;
+  int32_t epochsRun;
+  double finalLoss;
+  int32_t truePositives;
+  int32_t trueNegatives;
+  int32_t falsePositives;
+  int32_t falseNegatives;
+  double precision;
+  double recall;
+  double f1Score;
+  double errorRate;
+} ModelCache;
+
+// Features of one sample, 1 for X, -1 for O and 0 for an empty cell
+static inline const int8_t *ml_sample(const MLModel *model, int index) {
+  return model->features + (size_t)index * MAX_FEATURES;
+}
+
+// Function prototypes
+double calculate_error_probability(MLModel *model, int isTraining);
+void calculate_confusion_matrix(MLModel *model, int isTraining);
+void save_metrics_to_csv(MLModel *model);
+bool ml_init(MLModel *model);
+void ml_free(MLModel *model);
+bool ml_reserve(MLModel *model, int capacity);
+bool load_data(const char *filename, MLModel *model, DatasetError *error);
+void print_dataset_error(const char *filename, const DatasetError *error);
+void shuffle_data(MLModel *model);
+void split_data(MLModel *model);
+void train_linear_regression(MLModel *model);
+TrainConfig train_config(Optimizer optimizer);
+const char *optimizer_name(Optimizer optimizer);
+bool optimizer_from_name(const char *name, Optimizer *optimizer);
+const char *model_kind_name(ModelKind kind);
+bool model_kind_from_name(const char *name, ModelKind *kind);
+void train_mlp(MLModel *model);
+int ml_predict_sample(const MLModel *model, int index);
+void print_weights(double weights[MAX_FEATURES + 1]);
+void print_gradients(double gradient[MAX_FEATURES + 1]);
+double predict(const int8_t features[MAX_FEATURES], double weights[MAX_FEATURES + 1]);
+double predict_bitboard(Bitboard board, double weights[MAX_FEATURES + 1]);
+double add_noise(double prediction);
+int predict_move_with_imperfection(Bitboard board, double weights[]);
+int get_best_ai_move(Bitboard board, double weights[MAX_FEATURES + 1]);
+int get_best_mlp_move(Bitboard board, const MlpInt8 *mlp);
+double predict_mnk_cell(MnkVariant variant, const MnkBoard *board, int cell,
+                        const MLModel *model);
+int get_best_ai_move_mnk(MnkVariant variant, MnkBoard *board, const MLModel *model);
+SearchResult ml_ai_job(const AIJob *job, SearchProgress *progress);
+void evaluate_and_print_model_metrics(MLModel *model);
+bool dataset_hash(const char *filename, uint64_t *hash);
+bool model_cache_load(MLModel *model, const char *filename, uint64_t datasetHash);
+bool model_cache_save(const MLModel *model, const char *filename, uint64_t datasetHash);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// The packed dataset loads faster, but is only used when it was written
+// after the text one was last changed, so an edited text dataset is never
+// shadowed by a stale pack. Without it the text one is loaded
+static const char *dataset_to_load(void) {
+  struct stat text, packed;
+  if (stat(DATASET_PACKED_FILE, &packed) != 0) return DATASET_FILE;
+  if (stat(DATASET_FILE, &text) == 0 && text.st_mtime >= packed.st_mtime) {
+    printf("'%s' is not newer than '%s', loading the text dataset (make pack-dataset)\n",
+           DATASET_PACKED_FILE, DATASET_FILE);
+    return DATASET_FILE;
+  }
+  return DATASET_PACKED_FILE;
+}
+
+// Initialize and train the model. model->kind picks the linear model or the
+// MLP, and for the linear one model->config picks the optimizer, a zeroed
+// config trains with the default (Adam). When MODEL_CACHE_FILE
+// holds a model trained on the same dataset with the same settings it is
+// loaded instead, skipping training and the metrics.csv rewrite.
+// Returns false, after printing why, when the dataset cannot be loaded
+bool ml_init(MLModel *model) {
+  model->trainSplit = 0.8;  // Use 80% of data for training
+  model->sampleCount = 0;   // Initialize sample counter
+  if (model->config.maxEpochs == 0) model->config = train_config(OPTIMIZER_ADAM);
+
+  const char *dataset = dataset_to_load();
+  uint64_t hash = 0;
+  const bool hashed = dataset_hash(dataset, &hash);
+  const bool cached = hashed && model_cache_load(model, MODEL_CACHE_FILE, hash);
+
+  const char *name =
+      model->kind == MODEL_MLP ? model_kind_name(model->kind) : optimizer_name(model->config.optimizer);
+  if (cached) {
+    printf("Loaded the trained model (%s) from '%s', test F1 %.4f\n", name, MODEL_CACHE_FILE,
+           model->f1Score);
+  } else {
+    // Load training data from file
+    DatasetError error;
+    if (!load_data(dataset, model, &error)) {
+      print_dataset_error(dataset, &error);
+      return false;
+    }
+
+    shuffle_data(model);
+    split_data(model);
+
+    // Train the linear regression model or the network
+    if (model->kind == MODEL_MLP) {
+      printf("Training the MLP Model (%d hidden units)...\n", MLP_HIDDEN);
+      train_mlp(model);
+      printf("Stopped after %d epochs, training cross-entropy %.4f\n", model->epochsRun,
+             model->finalLoss);
+    } else {
+      printf("Training the Linear Regression Model (%s)...\n", name);
+      train_linear_regression(model);
+      printf("Stopped after %d epochs, training MSE %.4f\n", model->epochsRun, model->finalLoss);
+    }
+  }
+
+  // Print final weights and bias term
+  if (model->kind == MODEL_LINEAR) {
+    printf("Trained Weights and Bias:\n");
+    for (int i = 0; i < MAX_FEATURES; i++) {
+      printf("Weight[%d]: %.4f\n", i, model->weights[i]);
+    }
+    printf("Bias: %.4f\n", model->weights[MAX_FEATURES]);
+  }
+
+  if (cached) return true;
+  evaluate_and_print_model_metrics(model);
+  if (hashed && !model_cache_save(model, MODEL_CACHE_FILE, hash)) {
+    printf("Error saving the model to '%s'.\n", MODEL_CACHE_FILE);
+  }
+  return true;
+}
+
+// Release the dataset, the trained weights stay usable
+void ml_free(MLModel *model) {
+  free(model->features);
+  free(model->labels);
+  model->features = NULL;
+  model->labels = NULL;
+  model->capacity = 0;
+  model->sampleCount = 0;
+  model->trainSize = 0;
+  model->testSize = 0;
+}
+
+// Make room for at least capacity samples, keeping the ones loaded.
+// Returns false (leaving the model as it was) when out of memory
+bool ml_reserve(MLModel *model, int capacity) {
+  if (capacity <= model->capacity) return true;
+
+  int8_t *features = realloc(model->features, (size_t)capacity * MAX_FEATURES);
+  if (features == NULL) return false;
+  model->features = features;
+  int8_t *labels = realloc(model->labels, (size_t)capacity);
+  if (labels == NULL) return false;
+  model->labels = labels;
+  model->capacity = capacity;
+  return true;
+}
+
+// 64 bit FNV-1a hash of a file's bytes, false when it cannot be read
+bool dataset_hash(const char *filename, uint64_t *hash) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) return false;
+
+  uint64_t h = 14695981039346656037ull;
+  unsigned char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    for (size_t i = 0; i < read; i++) {
+      h ^= buffer[i];
+      h *= 1099511628211ull;
+    }
+  }
+  const bool ok = !ferror(file);
+  fclose(file);
+  *hash = h;
+  return ok;
+}
+
+// The key fields for model's current settings and dataset
+static ModelCache model_cache_key(const MLModel *model, uint64_t datasetHash) {
+  ModelCache cache;
+  memset(&cache, 0, sizeof(cache));  // Padding too, so files are byte identical
+  cache.magic = MODEL_CACHE_MAGIC;
+  cache.version = MODEL_CACHE_VERSION;
+  cache.featureCount = MAX_FEATURES;
+  cache.optimizer = (uint32_t)model->config.optimizer;
+  cache.kind = (uint32_t)model->kind;
+  cache.datasetHash = datasetHash;
+  cache.trainSplit = model->trainSplit;
+  cache.learningRate = model->config.learningRate;
+  cache.batchSize = model->config.batchSize;
+  cache.maxEpochs = model->config.maxEpochs;
+  cache.patience = model->config.patience;
+  cache.minDelta = model->config.minDelta;
+  return cache;
+}
+
+// Restore weights and metrics from filename if its key matches, returns
+// false (leaving model untouched) when the file is missing, stale or corrupt
+bool model_cache_load(MLModel *model, const char *filename, uint64_t datasetHash) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) return false;
+
+  ModelCache cache;
+  const bool read = fread(&cache, sizeof(cache), 1, file) == 1;
+  fclose(file);
+
+  const ModelCache key = model_cache_key(model, datasetHash);
+  if (!read || cache.magic != key.magic || cache.version != key.version ||
+      cache.featureCount != key.featureCount || cache.optimizer != key.optimizer ||
+      cache.kind != key.kind ||
+      cache.datasetHash != key.datasetHash || cache.trainSplit != key.trainSplit ||
+      cache.learningRate != key.learningRate || cache.batchSize != key.batchSize ||
+      cache.maxEpochs != key.maxEpochs || cache.patience != key.patience ||
+      cache.minDelta != key.minDelta) {
+    return false;
+  }
+
+  memcpy(model->weights, cache.weights, sizeof(model->weights));
+  model->mlp = cache.mlp;
+  mlp_quantize(&model->mlp, &model->mlpInt8);
+  model->epochsRun = cache.epochsRun;
+  model->finalLoss = cache.finalLoss;
+  model->truePositives = cache.truePositives;
+  model->trueNegatives = cache.trueNegatives;
+  model->falsePositives = cache.falsePositives;
+  model->falseNegatives = cache.falseNegatives;
+  model->precision = cache.precision;
+  model->recall = cache.recall;
+  model->f1Score = cache.f1Score;
+  model->errorRate = cache.errorRate;
+  return true;
+}
+
+// Write the trained model to filename. Goes through a temporary file so an
+// interrupted save never leaves a truncated cache behind
+bool model_cache_save(const MLModel *model, const char *filename, uint64_t datasetHash) {
+  ModelCache cache = model_cache_key(model, datasetHash);
+  memcpy(cache.weights, model->weights, sizeof(cache.weights));
+  cache.mlp = model->mlp;
+  cache.epochsRun = model->epochsRun;
+  cache.finalLoss = model->finalLoss;
+  cache.truePositives = model->truePositives;
+  cache.trueNegatives = model->trueNegatives;
+  cache.falsePositives = model->falsePositives;
+  cache.falseNegatives = model->falseNegatives;
+  cache.precision = model->precision;
+  cache.recall = model->recall;
+  cache.f1Score = model->f1Score;
+  cache.errorRate = model->errorRate;
+
+  char temp[512];
+  snprintf(temp, sizeof(temp), "%s.tmp", filename);
+  FILE *file = fopen(temp, "wb");
+  if (file == NULL) return false;
+  const bool written = fwrite(&cache, sizeof(cache), 1, file) == 1;
+  if (fclose(file) != 0 || !written) {
+    remove(temp);
+    return false;
+  }
+  remove(filename);  // rename does not replace an existing file on Windows
+  return rename(temp, filename) == 0;
+}
+
+void evaluate_and_print_model_metrics(MLModel *model) {
+  // Calculate confusion matrices for training data
+  calculate_confusion_matrix(model, 1);
+  int TP_train = model->truePositives;
+  int FP_train = model->falsePositives;
+  int FN_train = model->falseNegatives;
+
+  // Calculate confusion matrices for testing data
+  calculate_confusion_matrix(model, 0);
+  int TP_test = model->truePositives;
+  int TN_test = model->trueNegatives;
+  int FP_test = model->falsePositives;
+  int FN_test = model->falseNegatives;
+
+  // Calculate training metrics
+  double train_precision = (double)TP_train / (TP_train + FP_train + 1e-10);  // Add small constant to prevent div by 0
+  double train_recall = (double)TP_train / (TP_train + FN_train + 1e-10);
+  double train_f1 = 2 * (train_precision * train_recall) / (train_precision + train_recall + 1e-10);
+  double train_error = calculate_error_probability(model, 1);
+
+  // Calculate testing metrics
+  double test_precision = (double)TP_test / (TP_test + FP_test + 1e-10);
+  double test_recall = (double)TP_test / (TP_test + FN_test + 1e-10);
+  double test_f1 = 2 * (test_precision * test_recall) / (test_precision + test_recall + 1e-10);
+  double test_error = calculate_error_probability(model, 0);
+
+  // Print training metrics
+  printf("\nTraining Metrics:\n");
+  printf("Precision: %.4f\n", train_precision);
+  printf("Recall: %.4f\n", train_recall);
+  printf("F1 Score: %.4f\n", train_f1);
+  printf("Error Rate: %.4f\n", train_error);
+
+  // Print testing metrics
+  printf("\nTesting Metrics:\n");
+  printf("Precision: %.4f\n", test_precision);
+  printf("Recall: %.4f\n", test_recall);
+  printf("F1 Score: %.4f\n", test_f1);
+  printf("Error Rate: %.4f\n", test_error);
+
+  // print confusion matrix data
+  printf("\nConfusion Matrix Data:\n");
+  printf("True Positives: %d\n", TP_test);
+  printf("True Negatives: %d\n", TN_test);
+  printf("False Positives: %d\n", FP_test);
+  printf("False Negatives: %d\n", FN_test);
+
+
+  // Store final model metrics
+  model->precision = test_precision;
+  model->recall = test_recall;
+  model->f1Score = test_f1;
+  model->errorRate = test_error;
+
+  save_metrics_to_csv(model);
+}
+
+// Class the selected model gives sample index, the int8 network for the MLP
+int ml_predict_sample(const MLModel *model, int index) {
+  if (model->kind == MODEL_MLP) {
+    const int8_t *features = ml_sample(model, index);
+    Bitboard board = {0, 0};
+    for (int i = 0; i < MAX_FEATURES; i++) {
+      if (features[i]) bb_make_move(&board, i, features[i] > 0 ? X : O);
+    }
+    return mlp_int8_logit(&model->mlpInt8, board) >= 0;
+  }
+  return (int)predict(ml_sample(model, index), (double *)model->weights);
+}
+
+// Calculate classification error rate
+double calculate_error_probability(MLModel *model, int isTraining) {
+  int total_errors = 0;
+  // Select appropriate rows based on isTraining flag
+  int first = isTraining ? 0 : model->trainSize;
+  int count = isTraining ? model->trainSize : model->testSize;
+
+  // Count prediction errors
+  for (int i = first; i < first + count; i++) {
+    int predicted = ml_predict_sample(model, i);
+    if (predicted != model->labels[i]) {
+      total_errors++;
+    }
+  }
+
+  return (double)total_errors / count;
+}
+
+// Calculate confusion matrix metrics
+void calculate_confusion_matrix(MLModel *model, int isTraining) {
+  // Reset metrics
+  model->truePositives = 0;
+  model->trueNegatives = 0;
+  model->falsePositives = 0;
+  model->falseNegatives = 0;
+
+  // Select appropriate rows
+  int first = isTraining ? 0 : model->trainSize;
+  int count = isTraining ? model->trainSize : model->testSize;
+
+  // Calculate metrics
+  for (int i = first; i < first + count; i++) {
+    int predicted = ml_predict_sample(model, i);
+    int actual = model->labels[i];
+
+    // Update appropriate counter based on prediction vs actual
+    if (actual == 1) {
+      if (predicted == 1)
+        model->truePositives++;
+      else
+        model->falseNegatives++;
+    } else {
+      if (predicted == 1)
+        model->falsePositives++;
+      else
+        model->trueNegatives++;
+    }
+  }
+}
+
+// Save model metrics to CSV file
+void save_metrics_to_csv(MLModel *model) {
+  FILE *file = fopen("metrics.csv", "w");
+  if (file == NULL) {
+    printf("Error opening file to save metrics.\n");
+    return;
+  }
+
+  // Write headers and values
+  fprintf(file, "Metric,Value\n");
+  fprintf(file, "True Positive,%d\n", model->truePositives);
+  fprintf(file, "True Negative,%d\n", model->trueNegatives);
+  fprintf(file, "False Positive,%d\n", model->falsePositives);
+  fprintf(file, "False Negative,%d\n", model->falseNegatives);
+  fprintf(file, "Precision,%.6f\n", model->precision);
+  fprintf(file, "Recall,%.6f\n", model->recall);
+  fprintf(file, "F1-Score,%.6f\n", model->f1Score);
+
+  fclose(file);
+  printf("Metrics saved to 'metrics.csv'.\n");
+}
+
+// Parse one line "x,o,b,x,o,b,x,o,b,positive" (end excludes the newline),
+// false when it is not 9 cells and a label
+static bool dataset_parse_row(const char *line, const char *end, int8_t *features,
+                              int8_t *label) {
+  for (int i = 0; i < MAX_FEATURES; i++, line += 2) {
+    if (end - line < 2 || line[1] != ',') return false;
+    switch (line[0]) {
+      case 'x': features[i] = 1; break;   // X moves
+      case 'o': features[i] = -1; break;  // O moves
+      case 'b': features[i] = 0; break;   // Empty squares
+      default: return false;
+    }
+  }
+
+  if (end > line && end[-1] == '\r') end--;
+  if (end - line != 8) return false;
+  if (memcmp(line, "positive", 8) == 0)
+    *label = 1;
+  else if (memcmp(line, "negative", 8) == 0)
+    *label = 0;
+  else
+    return false;
+  return true;
+}
+
+// The mapped file cut into one run of whole lines per thread
+typedef struct {
+  const MappedFile *file;
+  MLModel *model;
+  size_t *bounds;       // threadCount + 1 byte offsets, each one at a line start
+  long long *rows;      // Rows found in each run, then the first row index of each
+  long long *lines;     // Lines in each run, blank ones included
+  long long *badLine;   // First malformed line within each run (from 0), -1 for none
+  bool parse;           // false counts the rows, true parses them into the model
+} DatasetRuns;
+
+// Count (first pass) or parse (second pass) the rows of this thread's run.
+// Blank lines are skipped. Pages are released every DATASET_SPLIT_BYTES
+// behind the read position, so the file never has to fit in memory
+static void dataset_run_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  DatasetRuns *runs = (DatasetRuns *)arg;
+  const char *text = runs->file->data;
+  const char *p = text + runs->bounds[thread];
+  const char *stop = text + runs->bounds[thread + 1];
+  const char *released = p;
+  long long row = runs->parse ? runs->rows[thread] : 0;
+  long long line = 0;
+
+  while (p < stop) {
+    if (p - released >= DATASET_SPLIT_BYTES) {
+      mapped_file_release(runs->file, (size_t)(released - text), (size_t)(p - text));
+      released = p;
+    }
+
+    const char *newline = memchr(p, '\n', (size_t)(stop - p));
+    const char *end = newline != NULL ? newline : stop;
+    const bool blank = end == p || (end - p == 1 && *p == '\r');
+
+    if (!blank && runs->parse) {
+      int8_t *features = runs->model->features + (size_t)row * MAX_FEATURES;
+      if (!dataset_parse_row(p, end, features, &runs->model->labels[row])) {
+        runs->badLine[thread] = line;
+        break;
+      }
+    }
+    if (!blank) row++;
+    line++;
+    p = end + 1;
+  }
+  mapped_file_release(runs->file, (size_t)(released - text), (size_t)(stop - text));
+
+  if (!runs->parse) {
+    runs->rows[thread] = row;
+    runs->lines[thread] = line;
+  }
+}
+
+// Unpack a packed dataset (see packed_dataset.h) after the samples already
+// loaded, checking the header and checksum. Pages are released behind the
+// read position like the text loader does
+static DatasetStatus load_packed(const MappedFile *file, MLModel *model, long long *badRow) {
+  PackedHeader header;
+  memcpy(&header, file->data, sizeof(header));
+  const uint64_t rows = (file->size - sizeof(header)) / sizeof(uint32_t);
+  if (header.version != PACKED_VERSION || header.featureCount != MAX_FEATURES ||
+      header.reserved != 0 || header.rowCount != rows ||
+      sizeof(header) + rows * sizeof(uint32_t) != file->size) {
+    return DATASET_BAD_HEADER;
+  }
+
+  const long long total = model->sampleCount + (long long)rows;
+  if (total > INT32_MAX || !ml_reserve(model, (int)total)) return DATASET_NO_MEMORY;
+
+  // The header is 32 bytes into a page aligned mapping, so rows are aligned
+  const uint32_t *words = (const uint32_t *)(file->data + sizeof(header));
+  const size_t block = DATASET_SPLIT_BYTES / sizeof(uint32_t);
+  uint64_t checksum = 14695981039346656037ull;
+  for (size_t begin = 0; begin < rows; begin += block) {
+    const size_t size = rows - begin < block ? rows - begin : block;
+    checksum = packed_checksum(checksum, words + begin, size);
+    for (size_t i = begin; i < begin + size; i++) {
+      const size_t row = (size_t)model->sampleCount + i;
+      if (!unpack_row(words[i], MAX_FEATURES, model->features + row * MAX_FEATURES,
+                      &model->labels[row])) {
+        *badRow = (long long)i + 1;
+        return DATASET_BAD_ROW;
+      }
+    }
+    mapped_file_release(file, sizeof(header) + begin * sizeof(uint32_t),
+                        sizeof(header) + (begin + size) * sizeof(uint32_t));
+  }
+  if (checksum != header.checksum) return DATASET_BAD_CHECKSUM;
+
+  model->sampleCount = (int)total;
+  return DATASET_OK;
+}
+
+// Load training data from file, appending to the samples already loaded.
+// Packed files (see packed_dataset.h) are recognised by their header and
+// unpacked directly. A text file is mapped and parsed in place: one pass counts the rows so the
+// feature matrix is allocated once at its final size, a second parses every
+// row straight into it. Files over DATASET_SPLIT_BYTES are cut at line
+// boundaries and both passes run on the training threads. On failure the
+// model keeps the samples it had and error says why
+bool load_data(const char *filename, MLModel *model, DatasetError *error) {
+  DatasetError result = {DATASET_OK, 0};
+  MappedFile file;
+  if (!mapped_file_open(filename, &file)) {
+    result.status = DATASET_OPEN_FAILED;
+    if (error != NULL) *error = result;
+    return false;
+  }
+  if (packed_is_header(file.data, file.size)) {
+    result.status = load_packed(&file, model, &result.line);
+    mapped_file_close(&file);
+    if (error != NULL) *error = result;
+    return result.status == DATASET_OK;
+  }
+
+  int threads = trainThreads > 0 ? trainThreads : threadpool_cpu_count();
+  const size_t maxThreads = file.size / DATASET_SPLIT_BYTES + 1;
+  if ((size_t)threads > maxThreads) threads = (int)maxThreads;
+
+  ThreadPool pool;
+  const bool pooled = threads > 1;
+  if (pooled) {
+    threadpool_init(&pool, threads);
+    threads = pool.threadCount;
+  }
+
+  size_t *bounds = malloc(sizeof(size_t) * (threads + 1));
+  long long *counts = malloc(sizeof(long long) * threads * 3);
+  long long total = model->sampleCount;
+  if (bounds == NULL || counts == NULL) result.status = DATASET_NO_MEMORY;
+
+  DatasetRuns runs = {&file, model, bounds, counts, counts + threads, counts + threads * 2,
+                      false};
+  if (result.status == DATASET_OK) {
+    // Even cuts, each moved forward to the start of the next line
+    bounds[0] = 0;
+    bounds[threads] = file.size;
+    for (int t = 1; t < threads; t++) {
+      size_t cut = file.size / threads * t;
+      if (cut < bounds[t - 1]) cut = bounds[t - 1];
+      const char *newline = memchr(file.data + cut, '\n', file.size - cut);
+      bounds[t] = newline != NULL ? (size_t)(newline - file.data) + 1 : file.size;
+    }
+
+    for (int pass = 0; pass < 2 && result.status == DATASET_OK; pass++) {
+      runs.parse = pass == 1;
+      if (runs.parse) {
+        // Row counts become each run's first row
+        for (int t = 0; t < threads; t++) {
+          const long long count = runs.rows[t];
+          runs.rows[t] = total;
+          total += count;
+          runs.badLine[t] = -1;
+        }
+        if (total > INT32_MAX || !ml_reserve(model, (int)total)) {
+          result.status = DATASET_NO_MEMORY;
+          break;
+        }
+      }
+
+      if (pooled)
+        threadpool_run(&pool, dataset_run_task, &runs);
+      else
+        dataset_run_task(&runs, 0, 1);
+    }
+  }
+
+  if (result.status == DATASET_OK) {
+    // The earliest malformed line in the file, counting the runs before it
+    long long line = 1;
+    for (int t = 0; t < threads && result.status == DATASET_OK; t++) {
+      if (runs.badLine[t] >= 0) {
+        result.status = DATASET_BAD_ROW;
+        result.line = line + runs.badLine[t];
+      }
+      line += runs.lines[t];
+    }
+  }
+  if (result.status == DATASET_OK) model->sampleCount = (int)total;
+
+  free(bounds);
+  free(counts);
+  if (pooled) threadpool_destroy(&pool);
+  mapped_file_close(&file);
+  if (error != NULL) *error = result;
+  return result.status == DATASET_OK;
+}
+
+void print_dataset_error(const char *filename, const DatasetError *error) {
+  switch (error->status) {
+    case DATASET_OPEN_FAILED:
+      printf("Error opening '%s'.\n", filename);
+      break;
+    case DATASET_NO_MEMORY:
+      printf("Error allocating memory for '%s'.\n", filename);
+      break;
+    case DATASET_BAD_ROW:
+      printf("Error reading '%s', line %lld is not 9 cells and a label.\n", filename,
+             error->line);
+      break;
+    case DATASET_BAD_HEADER:
+      printf("Error reading '%s', the packed header does not match a %d cell board "
+             "or the file size.\n", filename, MAX_FEATURES);
+      break;
+    case DATASET_BAD_CHECKSUM:
+      printf("Error reading '%s', the checksum does not match, the file is corrupt.\n", filename);
+      break;
+    default:
+      break;
+  }
+}
+
+// Split the shuffled samples by trainSplit: the first trainSize rows train
+// the model and the remaining testSize rows test it
+void split_data(MLModel *model) {
+  model->trainSize = (int)(model->trainSplit * model->sampleCount);
+  model->testSize = model->sampleCount - model->trainSize;
+}
+
+// Randomly shuffle the dataset
+void shuffle_data(MLModel *model) {
+  for (int i = model->sampleCount - 1; i > 0; i--) {
+    int j = rand() % (i + 1);
+
+    // Swap features
+    int8_t temp[MAX_FEATURES];
+    memcpy(temp, ml_sample(model, i), MAX_FEATURES);
+    memcpy(model->features + (size_t)i * MAX_FEATURES, ml_sample(model, j), MAX_FEATURES);
+    memcpy(model->features + (size_t)j * MAX_FEATURES, temp, MAX_FEATURES);
+
+    // Swap labels
+    int8_t label = model->labels[i];
+    model->labels[i] = model->labels[j];
+    model->labels[j] = label;
+  }
+}
+
+// Settings per optimizer. Plain gradient descent keeps the original fixed
+// 1000 full-batch epochs, the mini-batch optimizers stop once the training
+// MSE has not improved for a few epochs
+TrainConfig train_config(Optimizer optimizer) {
+  TrainConfig config = {optimizer, LEARNING_RATE, 0, EPOCHS, 0, 0};
+  switch (optimizer) {
+    case OPTIMIZER_SGD:
+      config = (TrainConfig){optimizer, 0.1, 32, 200, 5, 1e-4};
+      break;
+    case OPTIMIZER_MOMENTUM:
+      config = (TrainConfig){optimizer, 0.05, 64, 200, 5, 1e-4};
+      break;
+    case OPTIMIZER_ADAM:
+      config = (TrainConfig){optimizer, 0.05, 128, 200, 5, 1e-4};
+      break;
+    case OPTIMIZER_NORMAL:
+      config = (TrainConfig){optimizer, 0, 0, 1, 0, 0};
+      break;
+    default:
+      break;
+  }
+  return config;
+}
+
+const char *optimizer_name(Optimizer optimizer) {
+  static const char *NAMES[] = {"gd", "sgd", "momentum", "adam", "normal"};
+  return NAMES[optimizer];
+}
+
+const char *model_kind_name(ModelKind kind) {
+  static const char *NAMES[] = {"linear", "mlp"};
+  return NAMES[kind];
+}
+
+// Parse linear or mlp, returns false for anything else
+bool model_kind_from_name(const char *name, ModelKind *kind) {
+  for (int i = 0; i < NUM_MODEL_KINDS; i++) {
+    if (strcmp(name, model_kind_name((ModelKind)i)) == 0) {
+      *kind = (ModelKind)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Parse gd, sgd, momentum, adam or normal, returns false for anything else
+bool optimizer_from_name(const char *name, Optimizer *optimizer) {
+  for (int i = 0; i < NUM_OPTIMIZERS; i++) {
+    if (strcmp(name, optimizer_name((Optimizer)i)) == 0) {
+      *optimizer = (Optimizer)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Apply one update from the gradient summed over samples. velocity holds the
+// momentum (or Adam's first moment) and second Adam's second moment
+static void optimizer_step(const TrainConfig *config, double weights[MAX_FEATURES + 1],
+                           const double *gradient, int samples, double *velocity,
+                           double *second, long step) {
+  for (int j = 0; j <= MAX_FEATURES; j++) {
+    const double g = gradient[j] / samples;
+    switch (config->optimizer) {
+      case OPTIMIZER_MOMENTUM:
+        velocity[j] = MOMENTUM * velocity[j] + g;
+        weights[j] -= config->learningRate * velocity[j];
+        break;
+      case OPTIMIZER_ADAM: {
+        velocity[j] = ADAM_BETA1 * velocity[j] + (1 - ADAM_BETA1) * g;
+        second[j] = ADAM_BETA2 * second[j] + (1 - ADAM_BETA2) * g * g;
+        const double mean = velocity[j] / (1 - pow(ADAM_BETA1, step));
+        const double variance = second[j] / (1 - pow(ADAM_BETA2, step));
+        weights[j] -= config->learningRate * mean / (sqrt(variance) + ADAM_EPSILON);
+        break;
+      }
+      default:
+        weights[j] -= config->learningRate * g;
+        break;
+    }
+  }
+}
+
+typedef struct {
+  const MLModel *model;
+  LeastSquares *sums;  // One per thread
+} NormalSplit;
+
+// Each thread sums a contiguous run of the training samples
+static void normal_task(void *arg, int thread, int threadCount) {
+  NormalSplit *split = (NormalSplit *)arg;
+  const MLModel *model = split->model;
+  const int begin = (int)((long long)model->trainSize * thread / threadCount);
+  const int end = (int)((long long)model->trainSize * (thread + 1) / threadCount);
+  least_squares_init(&split->sums[thread], MAX_FEATURES);
+  for (int i = begin; i < end; i++) {
+    least_squares_add(&split->sums[thread], ml_sample(model, i), model->labels[i]);
+  }
+}
+
+// Exact least squares fit in one pass over the training set, see
+// least_squares.h. Sets over NORMAL_SPLIT_SAMPLES are summed on the training
+// threads and the per-thread sums merged
+static void train_normal_equations(MLModel *model) {
+  int threads = trainThreads > 0 ? trainThreads : threadpool_cpu_count();
+  if (model->trainSize <= NORMAL_SPLIT_SAMPLES) threads = 1;
+
+  ThreadPool pool;
+  const bool pooled = threads > 1 && threadpool_init(&pool, threads);
+  if (pooled) threads = pool.threadCount;
+  else threads = 1;
+
+  NormalSplit split = {model, malloc(sizeof(LeastSquares) * threads)};
+  if (split.sums == NULL) {
+    if (pooled) threadpool_destroy(&pool);
+    printf("Error allocating the normal equations.\n");
+    return;
+  }
+  if (pooled) {
+    threadpool_run(&pool, normal_task, &split);
+    threadpool_destroy(&pool);
+  } else {
+    normal_task(&split, 0, 1);
+  }
+  LeastSquares ls = split.sums[0];
+  for (int t = 1; t < threads; t++) least_squares_merge(&ls, &split.sums[t]);
+  free(split.sums);
+
+  if (!least_squares_solve(&ls, model->weights)) {
+    printf("Error solving the normal equations, too few training samples.\n");
+    return;
+  }
+  model->epochsRun = 1;
+  model->finalLoss = least_squares_mse(&ls, model->weights);
+}
+
+// Train linear regression model with the optimizer in model->config. The
+// samples are copied once into the vectorised kernel's layout (see
+// train_kernel.h) and visited in mini-batches, in a new random batch order
+// every epoch. Full batches are split across the training threads
+void train_linear_regression(MLModel *model) {
+  const TrainConfig *config = &model->config;
+  if (config->optimizer == OPTIMIZER_NORMAL) {
+    train_normal_equations(model);
+    return;
+  }
+
+  TrainSet set;
+  if (!train_set_init(&set, MAX_FEATURES, model->trainSize)) {
+    printf("Error allocating training data.\n");
+    return;
+  }
+  for (int i = 0; i < model->trainSize; i++) {
+    train_set_sample(&set, i, ml_sample(model, i), model->labels[i]);
+  }
+
+  // Batches start on TRAIN_ALIGN boundaries as the kernel needs
+  int batch = set.padded;
+  if (config->batchSize > 0 && config->batchSize < set.padded) {
+    batch = (config->batchSize + TRAIN_ALIGN - 1) / TRAIN_ALIGN * TRAIN_ALIGN;
+  }
+  const int batches = (set.padded + batch - 1) / batch;
+  int *order = malloc(sizeof(int) * batches);
+  if (order == NULL) {
+    printf("Error allocating training data.\n");
+    train_set_free(&set);
+    return;
+  }
+
+  double velocity[MAX_FEATURES + 1] = {0};
+  double second[MAX_FEATURES + 1] = {0};
+  double bestLoss = DBL_MAX;
+  int stale = 0;
+  long step = 0;
+  model->epochsRun = 0;
+  model->finalLoss = 0;
+
+  for (int epoch = 0; epoch < config->maxEpochs; epoch++) {
+    for (int b = 0; b < batches; b++) order[b] = b;
+    for (int b = batches - 1; b > 0; b--) {
+      int j = rand() % (b + 1);
+      int temp = order[b];
+      order[b] = order[j];
+      order[j] = temp;
+    }
+
+    double loss = 0;
+    for (int b = 0; b < batches; b++) {
+      const int begin = order[b] * batch;
+      const int end = begin + batch < set.padded ? begin + batch : set.padded;
+      const int samples = (end < set.count ? end : set.count) - begin;  // Padding excluded
+      double gradient[TRAIN_OUTPUTS(MAX_FEATURES)];
+
+      // Calculate gradients for the batch, split across threads when it is the whole set
+      if (batches == 1)
+        train_gradient_threaded(&set, model->weights, gradient);
+      else
+        train_gradient(&set, model->weights, begin, end, gradient);
+
+      loss += gradient[MAX_FEATURES + 1];
+      optimizer_step(config, model->weights, gradient, samples, velocity, second, ++step);
+    }
+
+    model->epochsRun = epoch + 1;
+    model->finalLoss = loss / set.count;
+
+    // Early stopping once the loss has plateaued
+    if (config->patience > 0) {
+      if (model->finalLoss < bestLoss - config->minDelta) {
+        bestLoss = model->finalLoss;
+        stale = 0;
+      } else if (++stale >= config->patience) {
+        break;
+      }
+    }
+  }
+
+  free(order);
+  train_set_free(&set);
+}
+
+// Train the network on the training rows, see mlp.h, and build its int8 copy
+void train_mlp(MLModel *model) {
+  mlp_init(&model->mlp);
+  model->epochsRun = mlp_train(&model->mlp, model->features, model->labels, model->trainSize,
+                               &model->finalLoss);
+  mlp_quantize(&model->mlp, &model->mlpInt8);
+}
+
+// Make prediction for single example
+double predict(const int8_t features[MAX_FEATURES], double weights[MAX_FEATURES + 1]) {
+  double result = weights[MAX_FEATURES];  // Bias term
+  for (int i = 0; i < MAX_FEATURES; i++) {
+    result += weights[i] * features[i];
+  }
+  return result >= 0.5 ? 1 : 0;  // Binary classification threshold
+}
+
+// Same prediction as predict(), reading the features straight off the bitboard:
+// X cells contribute +weight and O cells -weight, empty cells nothing
+double predict_bitboard(Bitboard board, double weights[MAX_FEATURES + 1]) {
+  return ml_board_value(board, weights) >= 0.5 ? 1 : 0;  // Binary classification threshold
+}
+
+// Add random noise to prediction
+double add_noise(double prediction) {
+  double noise = ((double)rand() / RAND_MAX) * 2 * MSE_THRESHOLD - MSE_THRESHOLD;  // Random noise within MSE range
+  return prediction + noise;
+}
+
+// Make prediction with deliberate imperfection
+int predict_move_with_imperfection(Bitboard board, double weights[]) {
+  double prediction = predict_bitboard(board, weights);
+  prediction = add_noise(prediction);  // Add noise
+  printf("\nPrediction With Imperfection: %lf\n", prediction);
+  return (prediction > 0.5) ? 1 : 0;
+}
+
+// Find best move for AI player. Every move is valued in one pass by
+// ml_score_moves, then thresholded and blurred like
+// predict_move_with_imperfection does for a single board
+int get_best_ai_move(Bitboard board, double weights[MAX_FEATURES + 1]) {
+  double best_score = DBL_MIN;
+  int best_move = -1;
+  double values[BB_CELLS];
+
+  // Try each possible move
+  BBMask moves = ml_score_moves(board, O, weights, values);
+  while (moves) {
+    int i = bb_pop_lsb(&moves);
+
+    if((double)rand() / RAND_MAX < FORGETFULNESS) {
+      if (aiLog) printf("\nAI Forgot, oh no! (Forgetful Factor) \n");
+      continue; // Forgetfulness factor
+    }
+
+    double prediction = add_noise(values[i] >= 0.5 ? 1 : 0);  // Add noise
+    double score = (prediction > 0.5) ? 1 : 0;
+
+    // Update best move if better score found
+    if (score > best_score) {
+      best_score = score;
+      best_move = i;
+    }
+  }
+  if (aiLog) printf("The best move for the bot is: %d (row %d, col %d)\n", best_move, best_move / 3 + 1, best_move % 3 + 1);
+  return best_move;
+}
+
+// Find best move for AI player with the network. Moves are ranked by X's
+// best reply to them (see mlp_int8_score_moves), so unlike the linear
+// model's 0/1 predictions they rarely tie. Forgetfulness and noise of
+// MSE_THRESHOLD times the score range still apply
+int get_best_mlp_move(Bitboard board, const MlpInt8 *mlp) {
+  int32_t scores[BB_CELLS];
+  BBMask moves = mlp_int8_score_moves(mlp, board, O, scores);
+
+  int32_t low = INT32_MAX, high = INT32_MIN;
+  for (BBMask rest = moves; rest;) {
+    const int i = bb_pop_lsb(&rest);
+    if (scores[i] < low) low = scores[i];
+    if (scores[i] > high) high = scores[i];
+  }
+
+  double best_score = -DBL_MAX;
+  int best_move = -1;
+  while (moves) {
+    int i = bb_pop_lsb(&moves);
+    if (best_move != -1 && (double)rand() / RAND_MAX < FORGETFULNESS) {
+      continue;  // Forgetfulness factor
+    }
+
+    double score = scores[i] + (add_noise(0) * ((double)high - low));
+    if (score > best_score) {
+      best_score = score;
+      best_move = i;
+    }
+  }
+  if (aiLog) printf("The best move for the bot is: %d (row %d, col %d)\n", best_move, best_move / 3 + 1, best_move % 3 + 1);
+  return best_move;
+}
+
+// Value of the move just played on cell for the player who played it, from
+// 0 (the opponent wins) to 1. The model only knows 3x3 boards, so on larger
+// variants it is applied to every 3x3 window covering the cell and the
+// window values averaged. Both models give the chance X has won a window:
+// the network as the sigmoid of its logit, the linear model as its
+// regression value clamped to 0..1
+double predict_mnk_cell(MnkVariant variant, const MnkBoard *board, int cell,
+                        const MLModel *model) {
+  const int row = cell / variant.cols;
+  const int col = cell % variant.cols;
+  const int mover = mnk_cell(board, cell);
+  double total = 0;
+  int windows = 0;
+
+  for (int top = row - 2; top <= row; top++) {
+    for (int left = col - 2; left <= col; left++) {
+      if (top < 0 || left < 0 || top + 3 > variant.rows || left + 3 > variant.cols) continue;
+
+      Bitboard window = {0, 0};
+      for (int i = 0; i < MAX_FEATURES; i++) {
+        const int piece = mnk_cell(board, (top + i / 3) * variant.cols + left + i % 3);
+        if (piece != EMPTY) bb_make_move(&window, i, piece);
+      }
+      double xWins;
+      if (model->kind == MODEL_MLP) {
+        const double logit = mlp_int8_logit(&model->mlpInt8, window) * (double)model->mlpInt8.scale;
+        xWins = 1 / (1 + exp(-logit));
+      } else {
+        xWins = fmin(fmax(ml_board_value(window, model->weights), 0), 1);
+      }
+      total += mover == X ? xWins : 1 - xWins;
+      windows++;
+    }
+  }
+  return windows ? total / windows : 0;
+}
+
+// Find best move for AI player on any m,n,k board
+int get_best_ai_move_mnk(MnkVariant variant, MnkBoard *board, const MLModel *model) {
+  if (mnk_is_classic(variant)) {
+    const Bitboard classic = mnk_to_bitboard(board);
+    if (model->kind == MODEL_MLP) return get_best_mlp_move(classic, &model->mlpInt8);
+    return get_best_ai_move(classic, (double *)model->weights);
+  }
+
+  double best_score = -DBL_MAX;
+  int best_move = -1;
+  int moves[MNK_MAX_CELLS];
+  int count = mnk_candidate_moves(variant, board, moves);
+
+  for (int i = 0; i < count; i++) {
+    if (best_move != -1 && (double)rand() / RAND_MAX < FORGETFULNESS) {
+      continue;  // Forgetfulness factor
+    }
+
+    mnk_make_move(variant, board, moves[i], O);  // Try O move
+    double score = add_noise(predict_mnk_cell(variant, board, moves[i], model));
+    mnk_unmake_move(variant, board, moves[i]);  // Undo move
+
+    if (score > best_score) {
+      best_score = score;
+      best_move = moves[i];
+    }
+  }
+  if (aiLog) printf("The best move for the bot is: %d (row %d, col %d)\n", best_move,
+                    best_move / variant.cols + 1, best_move % variant.cols + 1);
+  return best_move;
+}
+
+// Worker job for the NORMAL bot, job->engine holds the MLModel. The pickers
+// play O, so X's positions are handed to them with the colours swapped
+SearchResult ml_ai_job(const AIJob *job, SearchProgress *progress) {
+  (void)progress;
+  MnkBoard board = job->board;
+  if (job->player == X) {
+    mnk_clear(&board);
+    for (int cell = 0; cell < mnk_cells(job->variant); cell++) {
+      const int piece = mnk_cell(&job->board, cell);
+      if (piece != EMPTY) mnk_make_move(job->variant, &board, cell, -piece);
+    }
+  }
+  SearchResult result = {-1, 0, -1, 0, 0, 0};
+  result.bestMove = get_best_ai_move_mnk(job->variant, &board, (const MLModel *)job->engine);
+  return result;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
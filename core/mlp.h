@@ -0,0 +1,278 @@
+#ifndef MLP_H
+#define MLP_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitboard.h"
+
+// Small multi-layer perceptron for the 3x3 board: 9 cell inputs (1 X, -1 O,
+// 0 empty), MLP_HIDDEN ReLU units and one logit for "X wins". Trained in
+// float with Adam on binary cross-entropy, then served by an int8 copy.
+//
+// Int8 inference: layer 1 weights are quantised per hidden unit and stored by
+// cell, so a board's accumulators are the bias plus one int8 row per X cell
+// minus one per O cell, and a move adds or removes a single row. Layer 1's
+// scale is folded into the int8 output weights, so the whole forward pass is
+// integer adds and 16 multiplies, cheap on the Raspberry Pi 4 and anywhere
+// else. Scores are logits in units of MlpInt8.scale, so they compare directly.
+#define MLP_HIDDEN 16
+#define MLP_LEARNING_RATE 0.01
+#define MLP_BATCH 32
+#define MLP_EPOCHS 500
+#define MLP_PATIENCE 50      // Epochs without improvement before stopping
+#define MLP_MIN_DELTA 1e-4   // Smallest drop in training loss that counts as improvement
+#define MLP_ACC_MAX (1 << 16)  // Hidden accumulators are clamped here, layer 2 cannot overflow
+
+// Float model, trained and kept in the model cache. Only floats, so
+// training can treat it as one flat parameter array
+typedef struct {
+  float hidden[MLP_HIDDEN][BB_CELLS];
+  float hiddenBias[MLP_HIDDEN];
+  float output[MLP_HIDDEN];
+  float outputBias;
+} Mlp;
+
+#define MLP_PARAMS (int)(sizeof(Mlp) / sizeof(float))
+
+// Quantised model for inference, built from an Mlp by mlp_quantize
+typedef struct {
+  int8_t hidden[BB_CELLS][MLP_HIDDEN];  // By cell, so a move adds one row
+  int32_t hiddenBias[MLP_HIDDEN];
+  int8_t output[MLP_HIDDEN];            // Layer 2 weights times layer 1's scales
+  int32_t outputBias;
+  float scale;  // Logit of one output unit
+} MlpInt8;
+
+// function prototypes
+void mlp_init(Mlp *mlp);
+float mlp_logit(const Mlp *mlp, const int8_t features[BB_CELLS]);
+int mlp_train(Mlp *mlp, const int8_t *features, const int8_t *labels, int count,
+              double *finalLoss);
+void mlp_quantize(const Mlp *mlp, MlpInt8 *quantized);
+int32_t mlp_int8_logit(const MlpInt8 *mlp, Bitboard board);
+BBMask mlp_int8_score_moves(const MlpInt8 *mlp, Bitboard board, int player,
+                            int32_t scores[BB_CELLS]);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Random He initialisation from rand(), biases at 0
+void mlp_init(Mlp *mlp) {
+  memset(mlp, 0, sizeof(*mlp));
+  const float hiddenRange = sqrtf(6.0f / BB_CELLS);
+  const float outputRange = sqrtf(6.0f / MLP_HIDDEN);
+  for (int h = 0; h < MLP_HIDDEN; h++) {
+    for (int c = 0; c < BB_CELLS; c++) {
+      mlp->hidden[h][c] = ((float)rand() / RAND_MAX * 2 - 1) * hiddenRange;
+    }
+    mlp->output[h] = ((float)rand() / RAND_MAX * 2 - 1) * outputRange;
+  }
+}
+
+// Forward pass in float, activations receives the hidden ReLU outputs
+static float mlp_forward(const Mlp *mlp, const int8_t features[BB_CELLS],
+                         float activations[MLP_HIDDEN]) {
+  float logit = mlp->outputBias;
+  for (int h = 0; h < MLP_HIDDEN; h++) {
+    float sum = mlp->hiddenBias[h];
+    for (int c = 0; c < BB_CELLS; c++) sum += mlp->hidden[h][c] * features[c];
+    activations[h] = sum > 0 ? sum : 0;
+    logit += mlp->output[h] * activations[h];
+  }
+  return logit;
+}
+
+// Logit of "X wins" for one board, in float
+float mlp_logit(const Mlp *mlp, const int8_t features[BB_CELLS]) {
+  float activations[MLP_HIDDEN];
+  return mlp_forward(mlp, features, activations);
+}
+
+// Train on count samples with Adam over shuffled mini-batches, stopping once
+// the training loss has plateaued. Starts from the weights mlp holds, so
+// call mlp_init first. Returns the epochs run, finalLoss gets the mean
+// binary cross-entropy of the last epoch
+int mlp_train(Mlp *mlp, const int8_t *features, const int8_t *labels, int count,
+              double *finalLoss) {
+  int *order = malloc(sizeof(int) * count);
+  float *first = calloc(MLP_PARAMS * 3, sizeof(float));  // Adam moments, then the gradient
+  if (order == NULL || first == NULL || count == 0) {
+    free(order);
+    free(first);
+    *finalLoss = 0;
+    return 0;
+  }
+  float *second = first + MLP_PARAMS;
+  float *gradient = second + MLP_PARAMS;
+  float *params = (float *)mlp;
+  Mlp *grad = (Mlp *)gradient;
+
+  for (int i = 0; i < count; i++) order[i] = i;
+  double bestLoss = INFINITY;
+  int stale = 0;
+  int epochs = 0;
+  long step = 0;
+
+  for (int epoch = 0; epoch < MLP_EPOCHS; epoch++) {
+    for (int i = count - 1; i > 0; i--) {
+      int j = rand() % (i + 1);
+      int temp = order[i];
+      order[i] = order[j];
+      order[j] = temp;
+    }
+
+    double loss = 0;
+    for (int begin = 0; begin < count; begin += MLP_BATCH) {
+      const int end = begin + MLP_BATCH < count ? begin + MLP_BATCH : count;
+      memset(gradient, 0, sizeof(float) * MLP_PARAMS);
+
+      for (int b = begin; b < end; b++) {
+        const int8_t *x = features + (size_t)order[b] * BB_CELLS;
+        const float y = labels[order[b]];
+        float activations[MLP_HIDDEN];
+        const float logit = mlp_forward(mlp, x, activations);
+
+        // Cross-entropy of the sigmoid, written to stay finite for large logits
+        loss += log1p(exp(-fabs(logit))) + (logit > 0 ? logit : 0) - logit * y;
+        const float delta = 1.0f / (1.0f + expf(-logit)) - y;
+
+        grad->outputBias += delta;
+        for (int h = 0; h < MLP_HIDDEN; h++) {
+          grad->output[h] += delta * activations[h];
+          if (activations[h] <= 0) continue;
+          const float hiddenDelta = delta * mlp->output[h];
+          grad->hiddenBias[h] += hiddenDelta;
+          for (int c = 0; c < BB_CELLS; c++) grad->hidden[h][c] += hiddenDelta * x[c];
+        }
+      }
+
+      step++;
+      const double firstFix = 1 - pow(0.9, step);
+      const double secondFix = 1 - pow(0.999, step);
+      for (int p = 0; p < MLP_PARAMS; p++) {
+        const float g = gradient[p] / (end - begin);
+        first[p] = 0.9f * first[p] + 0.1f * g;
+        second[p] = 0.999f * second[p] + 0.001f * g * g;
+        params[p] -= (float)(MLP_LEARNING_RATE * (first[p] / firstFix) /
+                             (sqrt(second[p] / secondFix) + 1e-8));
+      }
+    }
+
+    epochs = epoch + 1;
+    *finalLoss = loss / count;
+    if (*finalLoss < bestLoss - MLP_MIN_DELTA) {
+      bestLoss = *finalLoss;
+      stale = 0;
+    } else if (++stale >= MLP_PATIENCE) {
+      break;
+    }
+  }
+
+  free(order);
+  free(first);
+  return epochs;
+}
+
+static int32_t mlp_round(double value, double limit) {
+  if (value > limit) value = limit;
+  if (value < -limit) value = -limit;
+  return (int32_t)lround(value);
+}
+
+// Symmetric int8 quantisation. Each hidden unit gets its own layer 1 scale,
+// which is then folded into that unit's output weight before layer 2 is
+// quantised with a single scale
+void mlp_quantize(const Mlp *mlp, MlpInt8 *quantized) {
+  double folded[MLP_HIDDEN];
+  double outputRange = 0;
+
+  for (int h = 0; h < MLP_HIDDEN; h++) {
+    double range = 0;
+    for (int c = 0; c < BB_CELLS; c++) range = fmax(range, fabs(mlp->hidden[h][c]));
+    const double scale = range > 0 ? range / 127 : 1;
+
+    for (int c = 0; c < BB_CELLS; c++) {
+      quantized->hidden[c][h] = (int8_t)mlp_round(mlp->hidden[h][c] / scale, 127);
+    }
+    quantized->hiddenBias[h] = mlp_round(mlp->hiddenBias[h] / scale, MLP_ACC_MAX);
+    folded[h] = mlp->output[h] * scale;
+    outputRange = fmax(outputRange, fabs(folded[h]));
+  }
+
+  const double scale = outputRange > 0 ? outputRange / 127 : 1;
+  for (int h = 0; h < MLP_HIDDEN; h++) {
+    quantized->output[h] = (int8_t)mlp_round(folded[h] / scale, 127);
+  }
+  quantized->outputBias = mlp_round(mlp->outputBias / scale, INT32_MAX / 2);
+  quantized->scale = (float)scale;
+}
+
+// out = acc plus (sign 1) or minus (sign -1) a layer 1 row
+static inline void mlp_int8_add(const int32_t acc[MLP_HIDDEN], const int8_t row[MLP_HIDDEN],
+                                int sign, int32_t out[MLP_HIDDEN]) {
+  for (int h = 0; h < MLP_HIDDEN; h++) out[h] = acc[h] + sign * row[h];
+}
+
+// Layer 1 accumulators of a board
+static void mlp_int8_hidden(const MlpInt8 *mlp, Bitboard board, int32_t acc[MLP_HIDDEN]) {
+  memcpy(acc, mlp->hiddenBias, sizeof(int32_t) * MLP_HIDDEN);
+  BBMask cells = board.x;
+  while (cells) mlp_int8_add(acc, mlp->hidden[bb_pop_lsb(&cells)], 1, acc);
+  cells = board.o;
+  while (cells) mlp_int8_add(acc, mlp->hidden[bb_pop_lsb(&cells)], -1, acc);
+}
+
+// ReLU and layer 2
+static inline int32_t mlp_int8_output(const MlpInt8 *mlp, const int32_t acc[MLP_HIDDEN]) {
+  int32_t logit = mlp->outputBias;
+  for (int h = 0; h < MLP_HIDDEN; h++) {
+    int32_t a = acc[h] < 0 ? 0 : acc[h];
+    a = a > MLP_ACC_MAX ? MLP_ACC_MAX : a;
+    logit += a * mlp->output[h];
+  }
+  return logit;
+}
+
+// Logit of "X wins" for one board, in units of mlp->scale
+int32_t mlp_int8_logit(const MlpInt8 *mlp, Bitboard board) {
+  int32_t acc[MLP_HIDDEN];
+  mlp_int8_hidden(mlp, board, acc);
+  return mlp_int8_output(mlp, acc);
+}
+
+// Score every move of player by the opponent's best reply to it: the model
+// only rates finished games, so a move is as good as the position the
+// opponent can make from it. Higher is better for player. Returns the mask
+// of empty cells, the only scores written
+BBMask mlp_int8_score_moves(const MlpInt8 *mlp, Bitboard board, int player,
+                            int32_t scores[BB_CELLS]) {
+  const BBMask empty = bb_empty(board);
+  int32_t acc[MLP_HIDDEN];
+  mlp_int8_hidden(mlp, board, acc);
+
+  BBMask moves = empty;
+  while (moves) {
+    const int cell = bb_pop_lsb(&moves);
+    int32_t moved[MLP_HIDDEN];
+    mlp_int8_add(acc, mlp->hidden[cell], player, moved);
+
+    // The opponent picks the reply worst for player, X maximises the logit
+    BBMask replies = (BBMask)(empty & ~(1u << cell));
+    int32_t worst = replies ? INT32_MAX : player * mlp_int8_output(mlp, moved);
+    while (replies) {
+      int32_t replied[MLP_HIDDEN];
+      mlp_int8_add(moved, mlp->hidden[bb_pop_lsb(&replies)], -player, replied);
+      const int32_t score = player * mlp_int8_output(mlp, replied);
+      if (score < worst) worst = score;
+    }
+    scores[cell] = worst;
+  }
+  return empty;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,311 @@
+#ifndef MNK_H
+#define MNK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bitboard.h"
+
+// Generalised m,n,k board: rows x cols cells, k in a row wins.
+// Cells are numbered row * cols + col and stored as one bitset per side.
+#define MNK_MAX_SIDE 16
+#define MNK_MAX_CELLS (MNK_MAX_SIDE * MNK_MAX_SIDE)
+#define MNK_WORDS (MNK_MAX_CELLS / 64)
+#define MNK_NEIGHBOUR_MIN_CELLS 26  // Boards this big only play next to stones
+#define MNK_SYMMETRIES 8  // Rotations and reflections of a square board, the first 4 fit any board
+
+typedef struct {
+  int rows;
+  int cols;
+  int k;  // Stones in a row needed to win
+} MnkVariant;
+
+typedef struct {
+  uint64_t x[MNK_WORDS];  // Cells taken by X
+  uint64_t o[MNK_WORDS];  // Cells taken by O
+  int moves;              // Stones on the board
+  uint64_t hash[MNK_SYMMETRIES];  // Zobrist key of the board seen through each symmetry
+} MnkBoard;
+
+// Zobrist keys per side and cell, a splitmix64 of the index so the table is
+// a compile time constant and the same every run
+#define MNK_MIX(z) ((z) ^ ((z) >> 31))
+#define MNK_MIX2(z) MNK_MIX((((z) ^ ((z) >> 27)) * 0x94D049BB133111EBULL))
+#define MNK_MIX1(z) MNK_MIX2((((z) ^ ((z) >> 30)) * 0xBF58476D1CE4E5B9ULL))
+#define MNK_KEY(i) MNK_MIX1(((i) + 1ULL) * 0x9E3779B97F4A7C15ULL)
+#define MNK_KEY4(i) MNK_KEY(i), MNK_KEY(i + 1), MNK_KEY(i + 2), MNK_KEY(i + 3)
+#define MNK_KEY16(i) MNK_KEY4(i), MNK_KEY4(i + 4), MNK_KEY4(i + 8), MNK_KEY4(i + 12)
+#define MNK_KEY64(i) MNK_KEY16(i), MNK_KEY16(i + 16), MNK_KEY16(i + 32), MNK_KEY16(i + 48)
+#define MNK_KEY256(i) MNK_KEY64(i), MNK_KEY64(i + 64), MNK_KEY64(i + 128), MNK_KEY64(i + 192)
+static const uint64_t MNK_ZOBRIST[2][MNK_MAX_CELLS] = {{MNK_KEY256(0)}, {MNK_KEY256(256)}};
+
+// Board sizes offered in the menu, the first one is classic Tic-Tac-Toe
+static const MnkVariant MNK_PRESETS[] = {
+    {3, 3, 3},   // Tic-Tac-Toe
+    {4, 4, 4},   // 4x4
+    {7, 7, 4},   // 7x7, four in a row
+    {15, 15, 5}  // Gomoku
+};
+#define MNK_NUM_PRESETS (int)(sizeof(MNK_PRESETS) / sizeof(MNK_PRESETS[0]))
+
+// function prototypes
+bool mnk_variant_valid(MnkVariant variant);
+bool mnk_is_win_at(MnkVariant variant, const MnkBoard *board, int cell);
+int mnk_check_winner(MnkVariant variant, const MnkBoard *board, int lastMove);
+int mnk_scan_winner(MnkVariant variant, const MnkBoard *board);
+int mnk_candidate_moves(MnkVariant variant, const MnkBoard *board, int moves[MNK_MAX_CELLS]);
+const char *mnk_variant_name(MnkVariant variant);
+Bitboard mnk_to_bitboard(const MnkBoard *board);
+void mnk_from_bitboard(MnkBoard *board, Bitboard bitboard);
+
+static inline int mnk_cells(MnkVariant variant) { return variant.rows * variant.cols; }
+
+// True for plain 3x3 three-in-a-row, which has the specialised bitboard engines
+static inline bool mnk_is_classic(MnkVariant variant) {
+  return variant.rows == 3 && variant.cols == 3 && variant.k == 3;
+}
+
+static inline void mnk_clear(MnkBoard *board) {
+  for (int w = 0; w < MNK_WORDS; w++) {
+    board->x[w] = 0;
+    board->o[w] = 0;
+  }
+  board->moves = 0;
+  for (int s = 0; s < MNK_SYMMETRIES; s++) board->hash[s] = 0;
+}
+
+// Symmetries of the board: all 8 on a square one, else the identity,
+// the two mirrors and the half turn
+static inline int mnk_symmetries(MnkVariant variant) {
+  return variant.rows == variant.cols ? MNK_SYMMETRIES : 4;
+}
+
+// Where cell lands under symmetry s, in the order of board->hash
+static inline int mnk_symmetry_cell(MnkVariant variant, int cell, int s) {
+  const int n = variant.cols, r = cell / n, c = cell % n;
+  const int rr = variant.rows - 1 - r, cc = n - 1 - c;
+  switch (s) {
+    case 1: return r * n + cc;   // Mirror left/right
+    case 2: return rr * n + c;   // Mirror top/bottom
+    case 3: return rr * n + cc;  // Rotate 180
+    case 4: return c * n + r;    // Main diagonal
+    case 5: return c * n + rr;   // Rotate 90
+    case 6: return cc * n + r;   // Rotate 270
+    case 7: return cc * n + rr;  // Anti diagonal
+    default: return cell;        // Identity
+  }
+}
+
+// Symmetry undoing s, rotations by 90 and 270 undo each other
+static inline int mnk_symmetry_inverse(int s) { return s == 5 ? 6 : s == 6 ? 5 : s; }
+
+// Toggle the stone of player on cell in the key of every symmetry. XOR is
+// its own inverse, so making and unmaking a move flip the same keys
+static inline void mnk_hash_toggle(MnkVariant variant, MnkBoard *board, int cell, int player) {
+  const uint64_t *keys = MNK_ZOBRIST[player == X ? 0 : 1];
+  const int n = variant.cols, r = cell / n, c = cell % n;
+  const int rr = variant.rows - 1 - r, cc = n - 1 - c;
+  board->hash[0] ^= keys[cell];
+  board->hash[1] ^= keys[r * n + cc];
+  board->hash[2] ^= keys[rr * n + c];
+  board->hash[3] ^= keys[rr * n + cc];
+  if (variant.rows != variant.cols) return;
+  board->hash[4] ^= keys[c * n + r];
+  board->hash[5] ^= keys[c * n + rr];
+  board->hash[6] ^= keys[cc * n + r];
+  board->hash[7] ^= keys[cc * n + rr];
+}
+
+// Smallest key over the symmetries, the same for every rotation and
+// reflection of a position. symmetry receives the one that produced it
+static inline uint64_t mnk_canonical_hash(MnkVariant variant, const MnkBoard *board,
+                                          int *symmetry) {
+  uint64_t best = board->hash[0];
+  *symmetry = 0;
+  for (int s = 1; s < mnk_symmetries(variant); s++) {
+    if (board->hash[s] < best) {
+      best = board->hash[s];
+      *symmetry = s;
+    }
+  }
+  return best;
+}
+
+// Returns X, O or EMPTY for a single cell
+static inline int mnk_cell(const MnkBoard *board, int cell) {
+  const uint64_t bit = 1ULL << (cell & 63);
+  if (board->x[cell >> 6] & bit) return X;
+  if (board->o[cell >> 6] & bit) return O;
+  return EMPTY;
+}
+
+static inline void mnk_make_move(MnkVariant variant, MnkBoard *board, int cell, int player) {
+  const uint64_t bit = 1ULL << (cell & 63);
+  if (player == X)
+    board->x[cell >> 6] |= bit;
+  else
+    board->o[cell >> 6] |= bit;
+  board->moves++;
+  mnk_hash_toggle(variant, board, cell, player);
+}
+
+static inline void mnk_unmake_move(MnkVariant variant, MnkBoard *board, int cell) {
+  mnk_hash_toggle(variant, board, cell, mnk_cell(board, cell));
+  const uint64_t bit = ~(1ULL << (cell & 63));
+  board->x[cell >> 6] &= bit;
+  board->o[cell >> 6] &= bit;
+  board->moves--;
+}
+
+// Empty cells held in word w of the bitset, limited to cells on the board
+static inline uint64_t mnk_empty_word(MnkVariant variant, const MnkBoard *board, int w) {
+  const int cells = mnk_cells(variant) - w * 64;
+  if (cells <= 0) return 0;
+  const uint64_t valid = cells >= 64 ? ~0ULL : (1ULL << cells) - 1;
+  return ~(board->x[w] | board->o[w]) & valid;
+}
+
+static inline bool mnk_is_full(MnkVariant variant, const MnkBoard *board) {
+  return board->moves >= mnk_cells(variant);
+}
+
+// Pop the lowest cell out of word w of a bitset, returning its cell index
+static inline int mnk_pop_lsb(uint64_t *mask, int w) {
+  int cell = w * 64 + __builtin_ctzll(*mask);
+  *mask &= *mask - 1;
+  return cell;
+}
+
+#ifdef ENGINE_IMPLEMENTATION
+
+bool mnk_variant_valid(MnkVariant variant) {
+  const int longest = variant.rows > variant.cols ? variant.rows : variant.cols;
+  return variant.rows >= 3 && variant.rows <= MNK_MAX_SIDE && variant.cols >= 3 &&
+         variant.cols <= MNK_MAX_SIDE && variant.k >= 3 && variant.k <= longest;
+}
+
+// Number of consecutive stones of player from (row, col) stepping by (dr, dc),
+// not counting the starting cell
+static int mnk_run_length(MnkVariant variant, const MnkBoard *board, int row, int col, int dr,
+                          int dc, int player) {
+  int count = 0;
+  row += dr;
+  col += dc;
+  while (row >= 0 && row < variant.rows && col >= 0 && col < variant.cols &&
+         mnk_cell(board, row * variant.cols + col) == player) {
+    count++;
+    row += dr;
+    col += dc;
+  }
+  return count;
+}
+
+// Does the stone on cell complete k in a row? Only the four lines through
+// that cell are walked, so the cost depends on k and not on the board size
+bool mnk_is_win_at(MnkVariant variant, const MnkBoard *board, int cell) {
+  static const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+  const int player = mnk_cell(board, cell);
+  if (player == EMPTY) return false;
+
+  const int row = cell / variant.cols;
+  const int col = cell % variant.cols;
+  for (int d = 0; d < 4; d++) {
+    const int dr = directions[d][0];
+    const int dc = directions[d][1];
+    int length = 1 + mnk_run_length(variant, board, row, col, dr, dc, player) +
+                 mnk_run_length(variant, board, row, col, -dr, -dc, player);
+    if (length >= variant.k) return true;
+  }
+  return false;
+}
+
+// Outcome after lastMove was played: X, O, TIE or EMPTY (ongoing).
+// Assumes the position before lastMove was still undecided
+int mnk_check_winner(MnkVariant variant, const MnkBoard *board, int lastMove) {
+  if (lastMove >= 0 && mnk_is_win_at(variant, board, lastMove)) {
+    return mnk_cell(board, lastMove);
+  }
+  if (mnk_is_full(variant, board)) return TIE;
+  return EMPTY;
+}
+
+// Outcome of an arbitrary position, checking every stone on the board
+int mnk_scan_winner(MnkVariant variant, const MnkBoard *board) {
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t stones = board->x[w] | board->o[w];
+    while (stones) {
+      int cell = mnk_pop_lsb(&stones, w);
+      if (mnk_is_win_at(variant, board, cell)) return mnk_cell(board, cell);
+    }
+  }
+  if (mnk_is_full(variant, board)) return TIE;
+  return EMPTY;
+}
+
+// Fill moves with the cells worth searching, returns how many there are.
+// On large boards only cells touching an existing stone are considered,
+// which is where every sensible move in k-in-a-row games is played
+int mnk_candidate_moves(MnkVariant variant, const MnkBoard *board, int moves[MNK_MAX_CELLS]) {
+  int count = 0;
+
+  if (mnk_cells(variant) < MNK_NEIGHBOUR_MIN_CELLS || board->moves == 0) {
+    if (board->moves == 0 && mnk_cells(variant) >= MNK_NEIGHBOUR_MIN_CELLS) {
+      moves[0] = (variant.rows / 2) * variant.cols + variant.cols / 2;  // Open in the centre
+      return 1;
+    }
+    for (int w = 0; w < MNK_WORDS; w++) {
+      uint64_t empty = mnk_empty_word(variant, board, w);
+      while (empty) moves[count++] = mnk_pop_lsb(&empty, w);
+    }
+    return count;
+  }
+
+  // Mark the 8 neighbours of every stone, then keep the empty ones
+  uint64_t near[MNK_WORDS] = {0};
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t stones = board->x[w] | board->o[w];
+    while (stones) {
+      int cell = mnk_pop_lsb(&stones, w);
+      int row = cell / variant.cols, col = cell % variant.cols;
+      for (int r = row - 1; r <= row + 1; r++) {
+        for (int c = col - 1; c <= col + 1; c++) {
+          if (r < 0 || r >= variant.rows || c < 0 || c >= variant.cols) continue;
+          int n = r * variant.cols + c;
+          near[n >> 6] |= 1ULL << (n & 63);
+        }
+      }
+    }
+  }
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t candidates = near[w] & mnk_empty_word(variant, board, w);
+    while (candidates) moves[count++] = mnk_pop_lsb(&candidates, w);
+  }
+  return count;
+}
+
+// Short label such as "7x7, 4 in a row" for the menu
+const char *mnk_variant_name(MnkVariant variant) {
+  static char name[32];
+  snprintf(name, sizeof(name), "%dx%d, %d in a row", variant.rows, variant.cols, variant.k);
+  return name;
+}
+
+// Classic boards share the cell numbering of the 3x3 bitboard
+Bitboard mnk_to_bitboard(const MnkBoard *board) {
+  Bitboard result = {(BBMask)(board->x[0] & BB_FULL), (BBMask)(board->o[0] & BB_FULL)};
+  return result;
+}
+
+void mnk_from_bitboard(MnkBoard *board, Bitboard bitboard) {
+  const MnkVariant classic = MNK_PRESETS[0];
+  mnk_clear(board);
+  for (int cell = 0; cell < BB_CELLS; cell++) {
+    const int piece = bb_cell(bitboard, cell);
+    if (piece != EMPTY) mnk_make_move(classic, board, cell, piece);
+  }
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -26,7 +26,7 @@ void pvp(GameData *gameData, GameResources *resources) {
     getMove(gameData, resources->clickSound, &restrictPlayer);
 
     // Check for winner
-    gameData->winner = check_winner(gameData->board);
+    gameData->winner = mnk_check_winner(gameData->variant, &gameData->board, gameData->lastMove);
     if (gameData->winner != EMPTY) {
       gameData->gameOver = true;
     }
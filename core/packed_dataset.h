@@ -0,0 +1,141 @@
+#ifndef PACKED_DATASET_H
+#define PACKED_DATASET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Packed binary dataset: a PackedHeader followed by one 32 bit word per row.
+// Cell i takes bits 2i and 2i+1 (0 empty, 1 X, 2 O) and the label is bit
+// PACKED_LABEL_BIT, so a 3x3 row is 19 bits instead of ~25 bytes of text and
+// needs no tokenising to load. Words are little-endian like every target of
+// this repo, and the checksum is FNV-1a over the row bytes
+#define PACKED_MAGIC 0x44545454u  // "TTTD"
+#define PACKED_VERSION 1
+#define PACKED_MAX_FEATURES 15  // Cells that fit below the label bit
+#define PACKED_LABEL_BIT 31
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t featureCount;
+  uint32_t reserved;  // 0, keeps rowCount 8 byte aligned
+  uint64_t rowCount;
+  uint64_t checksum;
+} PackedHeader;
+
+// function prototypes
+uint32_t packed_row(const int8_t *features, int featureCount, int label);
+bool unpack_row(uint32_t word, int featureCount, int8_t *features, int8_t *label);
+uint64_t packed_checksum(uint64_t hash, const uint32_t *rows, size_t count);
+bool packed_is_header(const void *data, size_t size);
+bool packed_write(const char *filename, const int8_t *features, const int8_t *labels,
+                  int featureCount, size_t count);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Pack one row of cells (1 X, -1 O, 0 empty) and its label into a word
+uint32_t packed_row(const int8_t *features, int featureCount, int label) {
+  uint32_t word = label ? 1u << PACKED_LABEL_BIT : 0;
+  for (int i = 0; i < featureCount; i++) {
+    const uint32_t code = features[i] > 0 ? 1 : features[i] < 0 ? 2 : 0;
+    word |= code << (2 * i);
+  }
+  return word;
+}
+
+// Cells of every 3 cell code (6 bits), then 1 if any of the codes is 3
+#define PACKED_CELL(code) ((code) == 1 ? 1 : (code) == 2 ? -1 : 0)
+#define PACKED_TRIPLE(t)                                                            \
+  {PACKED_CELL((t) & 3), PACKED_CELL(((t) >> 2) & 3), PACKED_CELL(((t) >> 4) & 3), \
+   ((t) & 3) == 3 || ((t) & 12) == 12 || ((t) & 48) == 48}
+#define PACKED_TRIPLE4(t) \
+  PACKED_TRIPLE(t), PACKED_TRIPLE(t + 1), PACKED_TRIPLE(t + 2), PACKED_TRIPLE(t + 3)
+#define PACKED_TRIPLE16(t) \
+  PACKED_TRIPLE4(t), PACKED_TRIPLE4(t + 4), PACKED_TRIPLE4(t + 8), PACKED_TRIPLE4(t + 12)
+static const int8_t PACKED_TRIPLES[64][4] = {PACKED_TRIPLE16(0), PACKED_TRIPLE16(16),
+                                             PACKED_TRIPLE16(32), PACKED_TRIPLE16(48)};
+
+// Reverse of packed_row, false when the word holds a cell code of 3 or
+// stray bits between the cells and the label. Cells are decoded three at a
+// time from PACKED_TRIPLES
+bool unpack_row(uint32_t word, int featureCount, int8_t *features, int8_t *label) {
+  const uint32_t cellBits = (1u << (2 * featureCount)) - 1;
+  if (word & ~cellBits & ~(1u << PACKED_LABEL_BIT)) return false;
+
+  int invalid = 0;
+  int i = 0;
+  for (; i + 3 <= featureCount; i += 3) {
+    const int8_t *triple = PACKED_TRIPLES[(word >> (2 * i)) & 63];
+    memcpy(features + i, triple, 3);
+    invalid |= triple[3];
+  }
+  for (; i < featureCount; i++) {
+    const int8_t *single = PACKED_TRIPLES[(word >> (2 * i)) & 3];
+    features[i] = single[0];
+    invalid |= single[3];
+  }
+  *label = (int8_t)(word >> PACKED_LABEL_BIT);
+  return !invalid;
+}
+
+// Continue an FNV-1a hash over count rows, start from 14695981039346656037
+uint64_t packed_checksum(uint64_t hash, const uint32_t *rows, size_t count) {
+  const unsigned char *bytes = (const unsigned char *)rows;
+  for (size_t i = 0; i < count * sizeof(uint32_t); i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Whether data starts with a packed dataset header
+bool packed_is_header(const void *data, size_t size) {
+  uint32_t magic;
+  if (data == NULL || size < sizeof(PackedHeader)) return false;
+  memcpy(&magic, data, sizeof(magic));
+  return magic == PACKED_MAGIC;
+}
+
+// Write count rows to filename in the packed format, through a temporary
+// file so an interrupted write never leaves a truncated dataset behind
+bool packed_write(const char *filename, const int8_t *features, const int8_t *labels,
+                  int featureCount, size_t count) {
+  if (featureCount > PACKED_MAX_FEATURES) return false;
+
+  char temp[512];
+  snprintf(temp, sizeof(temp), "%s.tmp", filename);
+  FILE *file = fopen(temp, "wb");
+  if (file == NULL) return false;
+
+  PackedHeader header = {PACKED_MAGIC, PACKED_VERSION, (uint32_t)featureCount, 0, count,
+                         14695981039346656037ull};
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+  // Rows go out in blocks, the checksum is patched into the header last
+  uint32_t block[4096];
+  for (size_t begin = 0; begin < count && written; begin += 4096) {
+    const size_t size = count - begin < 4096 ? count - begin : 4096;
+    for (size_t i = 0; i < size; i++) {
+      block[i] = packed_row(features + (begin + i) * featureCount, featureCount, labels[begin + i]);
+    }
+    header.checksum = packed_checksum(header.checksum, block, size);
+    written = fwrite(block, sizeof(uint32_t), size, file) == size;
+  }
+  if (written) {
+    written = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+  }
+
+  if (fclose(file) != 0 || !written) {
+    remove(temp);
+    return false;
+  }
+  remove(filename);  // rename does not replace an existing file on Windows
+  return rename(temp, filename) == 0;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitboard.h"
+#include "mnk.h"
+#include "threadpool.h"
+
+// Exhaustive game tree enumeration ("perft"): every line of play from a
+// position, counting the positions at each ply and the games that end
+// there. A game ends on a win or a full board, and every position is
+// counted, finished ones included. From the empty 3x3 board that is
+// 549,946 positions and 255,168 games.
+//
+// Backends walk the same tree with different move and win code, so equal
+// counts check one against the others:
+//   bitboard  Bitboard and bb_has_line on the mover's stones (3x3 only)
+//   array     int board[9] and check_winner, the original full scan,
+//             assembly on ARM (3x3 only)
+//   mnk       MnkBoard and mnk_is_win_at on the last move, any board
+//
+// Parallel: the tree is cut at a split ply, the backend collects the open
+// positions there, and the threads take them one at a time from a shared
+// counter, each counting into its own PerftCounts.
+#define PERFT_MAX_PLIES MNK_MAX_CELLS
+#define PERFT_TASKS_PER_THREAD 64  // Open positions wanted per thread at the split ply
+#define PERFT_MAX_TASKS (1 << 16)
+
+typedef enum { PERFT_BITBOARD,
+               PERFT_ARRAY,
+               PERFT_MNK } PerftBackend;
+#define NUM_PERFT_BACKENDS (PERFT_MNK + 1)
+
+// Per ply from the root: positions, and games won by X or O or drawn there
+typedef struct {
+  int plies;  // Deepest ply reached
+  unsigned long long nodes[PERFT_MAX_PLIES + 1];
+  unsigned long long xWins[PERFT_MAX_PLIES + 1];
+  unsigned long long oWins[PERFT_MAX_PLIES + 1];
+  unsigned long long draws[PERFT_MAX_PLIES + 1];
+} PerftCounts;
+
+// function prototypes
+const char *perft_backend_name(PerftBackend backend);
+bool perft_backend_supports(PerftBackend backend, MnkVariant variant);
+bool perft_run(MnkVariant variant, const MnkBoard *board, PerftBackend backend, int threads,
+               PerftCounts *counts);
+unsigned long long perft_total_nodes(const PerftCounts *counts);
+unsigned long long perft_total_games(const PerftCounts *counts);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+const char *perft_backend_name(PerftBackend backend) {
+  static const char *NAMES[] = {"bitboard", "array", "mnk"};
+  return NAMES[backend];
+}
+
+bool perft_backend_supports(PerftBackend backend, MnkVariant variant) {
+  return backend == PERFT_MNK || mnk_is_classic(variant);
+}
+
+// State of one walk: where the counts go and, while collecting the open
+// positions for the threads, the split ply and the list they go to
+typedef struct {
+  MnkVariant variant;
+  PerftCounts *counts;
+  int split;  // Ply to stop at and collect, -1 to walk to the end
+  MnkBoard *tasks;
+  int taskCount;
+} PerftWalk;
+
+// Count a position at ply, returns true when the walk goes on below it
+static inline bool perft_visit(PerftWalk *walk, int ply, int winner, bool full) {
+  PerftCounts *counts = walk->counts;
+  counts->nodes[ply]++;
+  if (ply > counts->plies) counts->plies = ply;
+  if (winner == X) counts->xWins[ply]++;
+  else if (winner == O) counts->oWins[ply]++;
+  else if (full) counts->draws[ply]++;
+  return winner == EMPTY && !full;
+}
+
+static void perft_collect(PerftWalk *walk, const MnkBoard *board) {
+  if (walk->taskCount < PERFT_MAX_TASKS) walk->tasks[walk->taskCount] = *board;
+  walk->taskCount++;
+}
+
+static void perft_bitboard(PerftWalk *walk, Bitboard board, int player, int ply) {
+  BBMask moves = bb_empty(board);
+  while (moves) {
+    Bitboard next = board;
+    bb_make_move(&next, bb_pop_lsb(&moves), player);
+    const int winner = bb_has_line(player == X ? next.x : next.o) ? player : EMPTY;
+    if (!perft_visit(walk, ply + 1, winner, bb_empty(next) == 0)) continue;
+    if (ply + 1 == walk->split) {
+      MnkBoard open;
+      mnk_from_bitboard(&open, next);
+      perft_collect(walk, &open);
+    } else {
+      perft_bitboard(walk, next, -player, ply + 1);
+    }
+  }
+}
+
+static void perft_array(PerftWalk *walk, int board[BB_CELLS], int player, int ply) {
+  for (int cell = 0; cell < BB_CELLS; cell++) {
+    if (board[cell] != EMPTY) continue;
+    board[cell] = player;
+    const int result = check_winner(board);
+    if (perft_visit(walk, ply + 1, result == TIE ? EMPTY : result, result == TIE)) {
+      if (ply + 1 == walk->split) {
+        MnkBoard open;
+        mnk_from_bitboard(&open, bb_from_array(board));
+        perft_collect(walk, &open);
+      } else {
+        perft_array(walk, board, -player, ply + 1);
+      }
+    }
+    board[cell] = EMPTY;
+  }
+}
+
+static void perft_mnk(PerftWalk *walk, MnkBoard *board, int player, int ply) {
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t moves = mnk_empty_word(walk->variant, board, w);
+    while (moves) {
+      const int cell = mnk_pop_lsb(&moves, w);
+      mnk_make_move(walk->variant, board, cell, player);
+      const int winner = mnk_is_win_at(walk->variant, board, cell) ? player : EMPTY;
+      if (perft_visit(walk, ply + 1, winner, mnk_is_full(walk->variant, board))) {
+        if (ply + 1 == walk->split)
+          perft_collect(walk, board);
+        else
+          perft_mnk(walk, board, -player, ply + 1);
+      }
+      mnk_unmake_move(walk->variant, board, cell);
+    }
+  }
+}
+
+// Walk the tree below board, player to move at ply
+static void perft_walk(PerftWalk *walk, PerftBackend backend, const MnkBoard *board, int player,
+                       int ply) {
+  if (backend == PERFT_BITBOARD) {
+    perft_bitboard(walk, mnk_to_bitboard(board), player, ply);
+  } else if (backend == PERFT_ARRAY) {
+    int cells[BB_CELLS];
+    bb_to_array(mnk_to_bitboard(board), cells);
+    perft_array(walk, cells, player, ply);
+  } else {
+    MnkBoard copy = *board;
+    perft_mnk(walk, &copy, player, ply);
+  }
+}
+
+typedef struct {
+  MnkVariant variant;
+  PerftBackend backend;
+  const MnkBoard *tasks;
+  int taskCount;
+  int split;
+  int player;  // Side to move at the split ply
+  atomic_int next;
+  PerftCounts *threadCounts;
+} PerftSplit;
+
+static void perft_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  PerftSplit *split = (PerftSplit *)arg;
+  PerftWalk walk = {split->variant, &split->threadCounts[thread], -1, NULL, 0};
+  int task;
+  while ((task = atomic_fetch_add(&split->next, 1)) < split->taskCount) {
+    perft_walk(&walk, split->backend, &split->tasks[task], split->player, split->split);
+  }
+}
+
+static void perft_add(PerftCounts *to, const PerftCounts *from) {
+  for (int ply = 0; ply <= from->plies; ply++) {
+    to->nodes[ply] += from->nodes[ply];
+    to->xWins[ply] += from->xWins[ply];
+    to->oWins[ply] += from->oWins[ply];
+    to->draws[ply] += from->draws[ply];
+  }
+  if (from->plies > to->plies) to->plies = from->plies;
+}
+
+// Enumerate every game from board, X moving first from the empty board,
+// on threads threads. Returns false when the backend cannot play variant,
+// the position is illegal or already over, or out of memory
+bool perft_run(MnkVariant variant, const MnkBoard *board, PerftBackend backend, int threads,
+               PerftCounts *counts) {
+  memset(counts, 0, sizeof(*counts));
+  if (!perft_backend_supports(backend, variant)) return false;
+  int xStones = 0, oStones = 0;
+  for (int w = 0; w < MNK_WORDS; w++) {
+    xStones += __builtin_popcountll(board->x[w]);
+    oStones += __builtin_popcountll(board->o[w]);
+  }
+  if (xStones != oStones && xStones != oStones + 1) return false;
+  if (mnk_scan_winner(variant, board) != EMPTY) return false;
+  const int player = xStones == oStones ? X : O;
+
+  PerftWalk walk = {variant, counts, -1, NULL, 0};
+  perft_visit(&walk, 0, EMPTY, false);
+  if (threads <= 1) {
+    perft_walk(&walk, backend, board, player, 0);
+    return true;
+  }
+
+  // Deepen the split ply until there is enough work to share out, the
+  // plies above it are counted while collecting
+  const int emptyCells = mnk_cells(variant) - board->moves;
+  walk.tasks = malloc(sizeof(MnkBoard) * PERFT_MAX_TASKS);
+  if (walk.tasks == NULL) return false;
+  for (int split = 1; split <= emptyCells; split++) {
+    memset(counts, 0, sizeof(*counts));
+    perft_visit(&walk, 0, EMPTY, false);
+    walk.split = split;
+    walk.taskCount = 0;
+    perft_walk(&walk, backend, board, player, 0);
+    if (walk.taskCount >= threads * PERFT_TASKS_PER_THREAD || split == emptyCells) break;
+    if (walk.taskCount * (emptyCells - split) > PERFT_MAX_TASKS) break;  // Next ply will not fit
+  }
+
+  PerftSplit split = {variant, backend, walk.tasks, walk.taskCount, walk.split,
+                      walk.split % 2 == 0 ? player : -player, 0,
+                      calloc(threads, sizeof(PerftCounts))};
+  ThreadPool pool;
+  const bool ok = split.threadCounts != NULL && threadpool_init(&pool, threads);
+  if (ok) {
+    threadpool_run(&pool, perft_task, &split);
+    threadpool_destroy(&pool);
+    for (int t = 0; t < threads; t++) perft_add(counts, &split.threadCounts[t]);
+  }
+  free(split.threadCounts);
+  free(walk.tasks);
+  return ok;
+}
+
+unsigned long long perft_total_nodes(const PerftCounts *counts) {
+  unsigned long long total = 0;
+  for (int ply = 0; ply <= counts->plies; ply++) total += counts->nodes[ply];
+  return total;
+}
+
+unsigned long long perft_total_games(const PerftCounts *counts) {
+  unsigned long long total = 0;
+  for (int ply = 0; ply <= counts->plies; ply++) {
+    total += counts->xWins[ply] + counts->oWins[ply] + counts->draws[ply];
+  }
+  return total;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
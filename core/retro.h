@@ -0,0 +1,451 @@
+#ifndef RETRO_H
+#define RETRO_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mapped_file.h"
+#include "mnk.h"
+#include "search.h"
+#include "threadpool.h"
+
+// Retrograde perfect-play tables for small m,n,k boards (4x4, 3x5, 4x5...),
+// where minimax from the root is far too slow to run per move.
+//
+// Positions are grouped by ply, X holding (ply + 1) / 2 stones and O ply / 2.
+// Inside a layer a position's index is the colex rank of the X cells times
+// the number of O placements, plus the rank of the O cells among the cells X
+// left empty, so every layer is a dense int8 array with no unused entries.
+// The solver starts from the full board and works back to the empty one: each
+// layer only reads the one after it, so just two layers are ever held in
+// memory and finished ones stream to the file.
+//
+// Scores follow the 3x3 solver table, for the side to move: RETRO_WIN - plies
+// for a forced win, the negation for a forced loss, 0 for a draw, and
+// RETRO_UNKNOWN for positions no game reaches (the side to move has a line).
+//
+// File: a RetroHeader, then the layers from the full board back to the empty
+// one, as the solver writes them. Tables are memory-mapped to be read.
+#define RETRO_MAGIC 0x52545454u  // "TTTR"
+#define RETRO_VERSION 1
+#define RETRO_MAX_CELLS 32  // Cells fit one 32 bit mask per side
+#define RETRO_MAX_LINES 256
+#define RETRO_WIN 100  // Above every ply count, like SOLVER_WIN on 3x3
+#define RETRO_UNKNOWN INT8_MIN
+#define RETRO_MEMORY_MB 1024  // Default cap on the two layers in memory
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t rows;
+  uint32_t cols;
+  uint32_t k;
+  uint32_t reserved;  // 0, keeps positions 8 byte aligned
+  uint64_t positions;
+} RetroHeader;
+
+// A solved variant mapped from its file
+typedef struct {
+  MnkVariant variant;
+  MappedFile file;
+  const int8_t *scores;
+  uint64_t layerOffset[RETRO_MAX_CELLS + 1];  // First score of each ply in scores
+  bool loaded;
+} RetroTable;
+
+typedef struct {
+  uint64_t positions;  // Entries written, RETRO_UNKNOWN ones included
+  uint64_t wins;       // Positions won, drawn and lost for the side to move
+  uint64_t draws;
+  uint64_t losses;
+  int rootScore;      // Score of the empty board
+  size_t peakBytes;   // Most layer memory held at once
+  double ms;
+} RetroStats;
+
+// function prototypes
+uint64_t retro_layer_size(int cells, int ply);
+size_t retro_memory_needed(MnkVariant variant);
+bool retro_supports(MnkVariant variant, size_t memoryLimit);
+bool retro_solve(MnkVariant variant, const char *filename, int threads, size_t memoryLimit,
+                 RetroStats *stats);
+bool retro_open(const char *filename, RetroTable *table);
+void retro_close(RetroTable *table);
+bool retro_covers(const RetroTable *table, MnkVariant variant);
+int retro_score(const RetroTable *table, const MnkBoard *board);
+SearchResult retro_root(const RetroTable *table, const MnkBoard *board, int player);
+
+extern RetroTable retroTable;  // Opened with --retro, used by the IMPOSSIBLE bot
+
+#ifdef ENGINE_IMPLEMENTATION
+
+RetroTable retroTable;
+static uint64_t retroChoose[RETRO_MAX_CELLS + 1][RETRO_MAX_CELLS + 1];
+
+// Pascal's triangle, filled before any thread reads it
+static void retro_init_choose(void) {
+  if (retroChoose[0][0] == 1) return;
+  for (int n = 0; n <= RETRO_MAX_CELLS; n++) {
+    retroChoose[n][0] = 1;
+    for (int r = 1; r <= n; r++) {
+      retroChoose[n][r] = retroChoose[n - 1][r - 1] + retroChoose[n - 1][r];
+    }
+  }
+}
+
+static inline uint64_t retro_choose(int n, int r) {
+  return r < 0 || r > n ? 0 : retroChoose[n][r];
+}
+
+// Positions with ply stones on a board of cells cells
+uint64_t retro_layer_size(int cells, int ply) {
+  retro_init_choose();
+  const int xStones = (ply + 1) / 2;
+  return retro_choose(cells, xStones) * retro_choose(cells - xStones, ply / 2);
+}
+
+// Bytes of the two largest neighbouring layers, what solving variant holds
+size_t retro_memory_needed(MnkVariant variant) {
+  const int cells = mnk_cells(variant);
+  size_t most = 0;
+  for (int ply = 0; ply < cells; ply++) {
+    const size_t bytes = retro_layer_size(cells, ply) + retro_layer_size(cells, ply + 1);
+    if (bytes > most) most = bytes;
+  }
+  return most;
+}
+
+bool retro_supports(MnkVariant variant, size_t memoryLimit) {
+  return mnk_variant_valid(variant) && mnk_cells(variant) <= RETRO_MAX_CELLS &&
+         retro_memory_needed(variant) <= memoryLimit;
+}
+
+// Colex rank of the set cells of mask among the masks with as many cells
+static inline uint64_t retro_rank(uint32_t mask) {
+  uint64_t rank = 0;
+  for (int stones = 1; mask; stones++) {
+    rank += retro_choose(__builtin_ctz(mask), stones);
+    mask &= mask - 1;
+  }
+  return rank;
+}
+
+// Rank of the O cells counting only the cells X left empty
+static inline uint64_t retro_rank_o(uint32_t o, uint32_t x) {
+  uint64_t rank = 0;
+  for (int stones = 1; o; stones++) {
+    const int cell = __builtin_ctz(o);
+    rank += retro_choose(cell - __builtin_popcount(x & ((1u << cell) - 1)), stones);
+    o &= o - 1;
+  }
+  return rank;
+}
+
+static uint32_t retro_unrank(uint64_t rank, int stones, int cells) {
+  uint32_t mask = 0;
+  for (int cell = cells - 1; stones > 0; cell--) {
+    if (retro_choose(cell, stones) <= rank) {
+      rank -= retro_choose(cell, stones);
+      mask |= 1u << cell;
+      stones--;
+    }
+  }
+  return mask;
+}
+
+// Spread the low bits of packed over the set cells of cells, in order
+static inline uint32_t retro_deposit(uint32_t packed, uint32_t cells) {
+  uint32_t mask = 0;
+  for (; cells && packed; packed >>= 1) {
+    if (packed & 1) mask |= cells & -cells;
+    cells &= cells - 1;
+  }
+  return mask;
+}
+
+// Index of a position in its layer
+static inline uint64_t retro_index(int cells, int ply, uint32_t x, uint32_t o) {
+  const int xStones = (ply + 1) / 2;
+  return retro_rank(x) * retro_choose(cells - xStones, ply / 2) + retro_rank_o(o, x);
+}
+
+// Every k in a row of the variant, and the ones through each cell
+typedef struct {
+  int count;
+  uint32_t lines[RETRO_MAX_LINES];
+  int cellCount[RETRO_MAX_CELLS];
+  uint32_t cellLines[RETRO_MAX_CELLS][RETRO_MAX_LINES / 4];  // 4 directions per cell
+} RetroLines;
+
+static void retro_build_lines(MnkVariant variant, RetroLines *lines) {
+  static const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+  memset(lines, 0, sizeof(*lines));
+  for (int row = 0; row < variant.rows; row++) {
+    for (int col = 0; col < variant.cols; col++) {
+      for (int d = 0; d < 4; d++) {
+        const int endRow = row + directions[d][0] * (variant.k - 1);
+        const int endCol = col + directions[d][1] * (variant.k - 1);
+        if (endRow >= variant.rows || endCol < 0 || endCol >= variant.cols) continue;
+        uint32_t line = 0;
+        for (int i = 0; i < variant.k; i++) {
+          line |= 1u << ((row + directions[d][0] * i) * variant.cols + col + directions[d][1] * i);
+        }
+        lines->lines[lines->count++] = line;
+        for (uint32_t cells = line; cells; cells &= cells - 1) {
+          const int cell = __builtin_ctz(cells);
+          lines->cellLines[cell][lines->cellCount[cell]++] = line;
+        }
+      }
+    }
+  }
+}
+
+static inline bool retro_has_line(const RetroLines *lines, uint32_t stones) {
+  for (int i = 0; i < lines->count; i++) {
+    if ((stones & lines->lines[i]) == lines->lines[i]) return true;
+  }
+  return false;
+}
+
+// Does the stone on cell finish a line of stones?
+static inline bool retro_line_at(const RetroLines *lines, uint32_t stones, int cell) {
+  for (int i = 0; i < lines->cellCount[cell]; i++) {
+    if ((stones & lines->cellLines[cell][i]) == lines->cellLines[cell][i]) return true;
+  }
+  return false;
+}
+
+typedef struct {
+  const RetroLines *lines;
+  int cells;
+  int ply;
+  int8_t *scores;      // Layer being solved
+  const int8_t *next;  // Solved layer one ply deeper
+  atomic_ullong nextX;  // X placement to claim next
+  RetroStats *threadStats;
+} RetroLayerJob;
+
+// Score of the position x, o with mover to move, from the next layer
+static int retro_position(const RetroLayerJob *job, uint32_t x, uint32_t o, int mover) {
+  const RetroLines *lines = job->lines;
+  const uint32_t mine = mover == X ? x : o;
+  const uint32_t theirs = mover == X ? o : x;
+  if (retro_has_line(lines, mine)) return RETRO_UNKNOWN;
+  if (retro_has_line(lines, theirs)) return -RETRO_WIN;
+  if (job->ply == job->cells) return 0;
+
+  const int childX = (job->ply + 2) / 2;
+  const uint64_t childOCount = retro_choose(job->cells - childX, (job->ply + 1) / 2);
+  const uint32_t full = job->cells == 32 ? ~0u : (1u << job->cells) - 1;
+  int best = -RETRO_WIN - 1;
+  for (uint32_t empty = full & ~(x | o); empty; empty &= empty - 1) {
+    const int cell = __builtin_ctz(empty);
+    const uint32_t bit = 1u << cell;
+    if (retro_line_at(lines, mine | bit, cell)) return RETRO_WIN - 1;  // Nothing beats it
+
+    const uint32_t nx = mover == X ? x | bit : x;
+    const uint32_t no = mover == O ? o | bit : o;
+    int value = -job->next[retro_rank(nx) * childOCount + retro_rank_o(no, nx)];
+    // Step one ply closer to zero so quicker wins and slower losses rank higher
+    if (value > 0) value--;
+    if (value < 0) value++;
+    if (value > best) best = value;
+  }
+  return best;
+}
+
+// Threads claim one X placement at a time and solve every O placement with it
+static void retro_layer_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  RetroLayerJob *job = (RetroLayerJob *)arg;
+  RetroStats *stats = &job->threadStats[thread];
+  const int xStones = (job->ply + 1) / 2, oStones = job->ply / 2;
+  const int mover = xStones == oStones ? X : O;
+  const uint64_t xCount = retro_choose(job->cells, xStones);
+  const uint64_t oCount = retro_choose(job->cells - xStones, oStones);
+  const uint32_t full = job->cells == 32 ? ~0u : (1u << job->cells) - 1;
+
+  uint64_t xRank;
+  while ((xRank = atomic_fetch_add(&job->nextX, 1)) < xCount) {
+    const uint32_t x = retro_unrank(xRank, xStones, job->cells);
+    int8_t *scores = job->scores + xRank * oCount;
+    uint64_t packed = (1ull << oStones) - 1;  // O cells among the empty ones, in colex order
+    for (uint64_t oRank = 0; oRank < oCount; oRank++) {
+      const int score = retro_position(job, x, retro_deposit((uint32_t)packed, full & ~x), mover);
+      scores[oRank] = (int8_t)score;
+      if (score != RETRO_UNKNOWN) {
+        if (score > 0) stats->wins++;
+        else if (score < 0) stats->losses++;
+        else stats->draws++;
+      }
+      if (packed) {  // Next mask with as many bits (Gosper's hack)
+        const uint64_t low = packed & -packed, ripple = packed + low;
+        packed = ripple | (((packed ^ ripple) >> 2) / low);
+      }
+    }
+  }
+}
+
+// Solve every position of variant on threads threads and write the table
+// to filename, holding at most memoryLimit bytes of layers. Returns false
+// when the variant does not fit, memory runs out or the file cannot be written
+bool retro_solve(MnkVariant variant, const char *filename, int threads, size_t memoryLimit,
+                 RetroStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  if (!retro_supports(variant, memoryLimit)) return false;
+  const int cells = mnk_cells(variant);
+  RetroLines *lines = malloc(sizeof(RetroLines));
+  RetroStats *threadStats = calloc(threads, sizeof(RetroStats));
+  if (lines == NULL || threadStats == NULL) {
+    free(lines);
+    free(threadStats);
+    return false;
+  }
+  retro_build_lines(variant, lines);
+
+  char temp[512];
+  snprintf(temp, sizeof(temp), "%s.tmp", filename);
+  FILE *file = fopen(temp, "wb");
+  RetroHeader header = {RETRO_MAGIC, RETRO_VERSION, variant.rows, variant.cols, variant.k, 0, 0};
+  for (int ply = 0; ply <= cells; ply++) header.positions += retro_layer_size(cells, ply);
+  bool failed = file == NULL || fwrite(&header, sizeof(header), 1, file) != 1;
+
+  ThreadPool pool;
+  const bool pooled = !failed && threads > 1 && threadpool_init(&pool, threads);
+  failed |= threads > 1 && !pooled;
+
+  const double start = search_now_ms();
+  int8_t *next = NULL;
+  for (int ply = cells; ply >= 0 && !failed; ply--) {
+    const uint64_t size = retro_layer_size(cells, ply);
+    int8_t *scores = malloc(size);
+    if (scores == NULL) {
+      failed = true;
+      break;
+    }
+    const size_t held = size + (ply < cells ? retro_layer_size(cells, ply + 1) : 0);
+    if (held > stats->peakBytes) stats->peakBytes = held;
+
+    RetroLayerJob job = {lines, cells, ply, scores, next, 0, threadStats};
+    if (pooled)
+      threadpool_run(&pool, retro_layer_task, &job);
+    else
+      retro_layer_task(&job, 0, 1);
+
+    failed = fwrite(scores, 1, size, file) != size;
+    if (ply == 0) stats->rootScore = scores[0];
+    free(next);
+    next = scores;
+  }
+  free(next);
+  if (pooled) threadpool_destroy(&pool);
+  stats->ms = search_now_ms() - start;
+
+  for (int t = 0; t < threads; t++) {
+    stats->wins += threadStats[t].wins;
+    stats->draws += threadStats[t].draws;
+    stats->losses += threadStats[t].losses;
+  }
+  stats->positions = header.positions;
+  free(threadStats);
+  free(lines);
+
+  if (file != NULL && fclose(file) != 0) failed = true;
+  if (failed) {
+    if (file != NULL) remove(temp);
+    return false;
+  }
+  remove(filename);  // rename does not replace an existing file on Windows
+  return rename(temp, filename) == 0;
+}
+
+// Map a table written by retro_solve, false when it is missing or damaged
+bool retro_open(const char *filename, RetroTable *table) {
+  memset(table, 0, sizeof(*table));
+  if (!mapped_file_open(filename, &table->file)) return false;
+
+  RetroHeader header = {0};
+  bool valid = table->file.size >= sizeof(header);
+  if (valid) memcpy(&header, table->file.data, sizeof(header));
+  valid = valid && header.magic == RETRO_MAGIC && header.version == RETRO_VERSION;
+  table->variant = (MnkVariant){(int)header.rows, (int)header.cols, (int)header.k};
+  valid = valid && mnk_variant_valid(table->variant) &&
+          mnk_cells(table->variant) <= RETRO_MAX_CELLS;
+
+  if (valid) {
+    // Layers run from the full board back to the empty one
+    const int cells = mnk_cells(table->variant);
+    uint64_t offset = 0;
+    for (int ply = cells; ply >= 0; ply--) {
+      table->layerOffset[ply] = offset;
+      offset += retro_layer_size(cells, ply);
+    }
+    valid = offset == header.positions && table->file.size == sizeof(header) + offset;
+  }
+  if (!valid) {
+    mapped_file_close(&table->file);
+    return false;
+  }
+  table->scores = (const int8_t *)table->file.data + sizeof(header);
+  table->loaded = true;
+  return true;
+}
+
+void retro_close(RetroTable *table) {
+  if (table->loaded) mapped_file_close(&table->file);
+  memset(table, 0, sizeof(*table));
+}
+
+bool retro_covers(const RetroTable *table, MnkVariant variant) {
+  return table->loaded && table->variant.rows == variant.rows &&
+         table->variant.cols == variant.cols && table->variant.k == variant.k;
+}
+
+// Score for the side to move, RETRO_UNKNOWN when the table does not hold board
+int retro_score(const RetroTable *table, const MnkBoard *board) {
+  const int cells = mnk_cells(table->variant);
+  const uint32_t x = (uint32_t)board->x[0], o = (uint32_t)board->o[0];
+  const int ply = __builtin_popcount(x) + __builtin_popcount(o);
+  if (!table->loaded || ply > cells || __builtin_popcount(x) != (ply + 1) / 2) {
+    return RETRO_UNKNOWN;
+  }
+  return table->scores[table->layerOffset[ply] + retro_index(cells, ply, x, o)];
+}
+
+// Score player's moves by looking up each reply position, negated since the
+// opponent is to move there, like mm_table_root on 3x3
+SearchResult retro_root(const RetroTable *table, const MnkBoard *board, int player) {
+  SearchResult result = {-1, -SEARCH_INF, -1, -SEARCH_INF, 0, 0};
+  MnkBoard next = *board;
+
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t moves = mnk_empty_word(table->variant, board, w);
+    while (moves) {
+      const int cell = mnk_pop_lsb(&moves, w);
+      mnk_make_move(table->variant, &next, cell, player);
+      const int score = -retro_score(table, &next);
+      mnk_unmake_move(table->variant, &next, cell);
+      result.nodes++;
+
+      if (score > result.bestScore) {
+        result.secondMove = result.bestMove;
+        result.secondScore = result.bestScore;
+        result.bestMove = cell;
+        result.bestScore = score;
+      } else if (score > result.secondScore) {
+        result.secondMove = cell;
+        result.secondScore = score;
+      }
+    }
+  }
+  result.depth = mnk_cells(table->variant) - board->moves;  // Solved to the end
+  return result;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,437 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "mnk.h"
+#include "threadpool.h"
+#include "transposition.h"
+
+// Alpha-beta search for generalised m,n,k boards. Scores are negamax style,
+// from the point of view of the side to move.
+#define SEARCH_WIN 100000  // Win score, minus the ply it happens at
+#define SEARCH_INF 1000000
+#define SEARCH_EVAL_LIMIT (SEARCH_WIN / 2)  // Heuristic scores stay below any win
+#define SEARCH_BUDGET_MS 50.0               // Default time per AI move
+#define SEARCH_CHECK_INTERVAL 1024          // Nodes between clock checks
+
+typedef struct {
+  int bestMove;
+  int bestScore;
+  int secondMove;  // -1 when there is only one legal move
+  int secondScore;
+  int depth;                     // Deepest fully searched iteration
+  unsigned long long int nodes;  // Positions visited by this search
+} SearchResult;
+
+// Live view of a running search, shared with the thread that started it
+typedef struct {
+  atomic_bool cancel;  // Set by the owner to stop the search early
+  atomic_int depth;    // Deepest finished iteration so far
+  atomic_ullong nodes;  // Positions visited so far
+} SearchProgress;
+
+// Per search state, lets a running search notice that its time is up
+typedef struct {
+  double deadline;  // search_now_ms() value to stop at, 0 for no limit
+  bool aborted;     // Set once the search has to stop, results are then discarded
+  unsigned long long int nodes;
+  SearchProgress *progress;  // Optional, NULL when nobody is watching
+  ThreadPool *pool;          // Splits the root moves, NULL searches them on the calling thread
+  unsigned long long int ttProbes;
+  unsigned long long int ttHits;
+} SearchContext;
+
+// Positions visited by all searches and their transposition table lookups,
+// for profiling. Atomic since games on several threads may search at once
+extern atomic_ullong searchNodes;
+extern atomic_ullong ttProbes;
+extern atomic_ullong ttHits;
+
+// Thread count for searches, 0 means one per core
+extern int searchThreads;
+
+// function prototypes
+double search_now_ms(void);
+void search_set_threads(int threads);
+int mnk_evaluate(MnkVariant variant, const MnkBoard *board, int player);
+int mnk_negamax(SearchContext *ctx, MnkVariant variant, MnkBoard *board, int lastMove,
+                int player, int ply, int maxDepth, int alpha, int beta);
+SearchResult search_root_moves(SearchContext *ctx, MnkVariant variant, MnkBoard *board,
+                               int player, int maxDepth, const int *moves, int count,
+                               int *scores);
+SearchResult search_root(MnkVariant variant, MnkBoard *board, int player, int maxDepth);
+SearchResult search_iterative(MnkVariant variant, MnkBoard *board, int player, double budgetMs,
+                              int maxDepth, SearchProgress *progress);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+atomic_ullong searchNodes = 0;
+atomic_ullong ttProbes = 0;
+atomic_ullong ttHits = 0;
+
+// Monotonic wall clock in milliseconds
+double search_now_ms(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+// Static evaluation of a position cut off by the depth limit. Every run of
+// k cells holding stones of only one side can still become a win, and
+// counts for that side by the cube of how many stones it already has
+int mnk_evaluate(MnkVariant variant, const MnkBoard *board, int player) {
+  static const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+  int score = 0;
+
+  for (int d = 0; d < 4; d++) {
+    const int dr = directions[d][0];
+    const int dc = directions[d][1];
+    for (int row = 0; row < variant.rows; row++) {
+      for (int col = 0; col < variant.cols; col++) {
+        // Skip windows that would run off the board
+        const int endRow = row + (variant.k - 1) * dr;
+        const int endCol = col + (variant.k - 1) * dc;
+        if (endRow >= variant.rows || endCol < 0 || endCol >= variant.cols) continue;
+
+        int xCount = 0, oCount = 0;
+        for (int i = 0; i < variant.k; i++) {
+          int cell = mnk_cell(board, (row + i * dr) * variant.cols + col + i * dc);
+          if (cell == X) xCount++;
+          if (cell == O) oCount++;
+        }
+        if (xCount && !oCount) score += xCount * xCount * xCount;
+        if (oCount && !xCount) score -= oCount * oCount * oCount;
+      }
+    }
+  }
+
+  if (score > SEARCH_EVAL_LIMIT) score = SEARCH_EVAL_LIMIT;
+  if (score < -SEARCH_EVAL_LIMIT) score = -SEARCH_EVAL_LIMIT;
+  return player == X ? score : -score;
+}
+
+// Key of a position in the transposition table: the canonical key of the
+// stones, the variant and the side to move
+static uint64_t search_tt_key(MnkVariant variant, const MnkBoard *board, int player,
+                              int *symmetry) {
+  const uint64_t salt = MNK_KEY(1024ULL + (variant.rows * 32ULL + variant.cols) * 32 + variant.k);
+  return mnk_canonical_hash(variant, board, symmetry) ^ salt ^ (player == X ? MNK_KEY(512) : 0);
+}
+
+// Win and loss scores count the plies from the root, the table keeps them
+// counted from the stored node so they stay right wherever it is reached
+static int search_tt_value(int score, int ply) {
+  if (score > SEARCH_EVAL_LIMIT) return score - ply;
+  if (score < -SEARCH_EVAL_LIMIT) return score + ply;
+  return score;
+}
+
+static void search_tt_store(MnkVariant variant, uint64_t key, int symmetry, int ply,
+                            int remaining, int score, int bound, int bestMove) {
+  if (score > SEARCH_EVAL_LIMIT) score += ply;
+  if (score < -SEARCH_EVAL_LIMIT) score -= ply;
+  const TTEntry entry = {score, bound, remaining, mnk_symmetry_cell(variant, bestMove, symmetry)};
+  tt_store(key, entry);
+}
+
+// Negamax with alpha-beta pruning. lastMove is the move that led here
+// (or -1), so only the lines through it have to be checked for a win.
+// Positions are cached in the transposition table, whose best move is
+// searched first. A stored value is only returned at the remaining depth it
+// was searched to: a deeper one would make results depend on which searches
+// ran first, and so on the thread count (see search_root_moves)
+int mnk_negamax(SearchContext *ctx, MnkVariant variant, MnkBoard *board, int lastMove,
+                int player, int ply, int maxDepth, int alpha, int beta) {
+  ctx->nodes++;
+
+  // Every few nodes publish progress and give up once the time budget is
+  // spent or the owner cancelled, the caller then drops this iteration
+  if ((ctx->nodes % SEARCH_CHECK_INTERVAL) == 0) {
+    if (ctx->progress != NULL) {
+      atomic_fetch_add(&ctx->progress->nodes, SEARCH_CHECK_INTERVAL);
+      if (atomic_load(&ctx->progress->cancel)) ctx->aborted = true;
+    }
+    if (ctx->deadline > 0 && search_now_ms() >= ctx->deadline) ctx->aborted = true;
+  }
+  if (ctx->aborted) return 0;
+
+  // The opponent just completed a line
+  if (lastMove >= 0 && mnk_is_win_at(variant, board, lastMove)) return -(SEARCH_WIN - ply);
+
+  // No more moves is a tie, out of depth falls back to the heuristic
+  if (mnk_is_full(variant, board)) return 0;
+  if (ply > maxDepth) return mnk_evaluate(variant, board, player);
+
+  const int remaining = maxDepth - ply;
+  int symmetry;
+  const uint64_t key = search_tt_key(variant, board, player, &symmetry);
+  int hashMove = -1;
+  TTEntry entry;
+  ctx->ttProbes++;
+  if (tt_probe(key, &entry)) {
+    ctx->ttHits++;
+    if (entry.depth == remaining) {
+      const int value = search_tt_value(entry.value, ply);
+      if (entry.bound == TT_EXACT) return value;
+      if (entry.bound == TT_LOWER && value >= beta) return value;
+      if (entry.bound == TT_UPPER && value <= alpha) return value;
+    }
+    if (entry.bestMove >= 0) {
+      hashMove = mnk_symmetry_cell(variant, entry.bestMove, mnk_symmetry_inverse(symmetry));
+    }
+  }
+
+  int moves[MNK_MAX_CELLS];
+  int count = mnk_candidate_moves(variant, board, moves);
+  for (int i = 1; i < count; i++) {
+    if (moves[i] != hashMove) continue;
+    for (int j = i; j > 0; j--) moves[j] = moves[j - 1];  // The others keep their order
+    moves[0] = hashMove;
+    break;
+  }
+
+  const int alphaStart = alpha;
+  int best = -SEARCH_INF;
+  int bestMove = moves[0];
+  for (int i = 0; i < count; i++) {
+    mnk_make_move(variant, board, moves[i], player);
+    int score = -mnk_negamax(ctx, variant, board, moves[i], -player, ply + 1, maxDepth, -beta,
+                             -alpha);
+    mnk_unmake_move(variant, board, moves[i]);
+
+    if (score > best) {
+      best = score;
+      bestMove = moves[i];
+    }
+    if (best > alpha) alpha = best;
+    if (alpha >= beta) break;  // Cut-off, the opponent will avoid this line
+  }
+
+  // An aborted search returned made up scores, keep them out of the table
+  if (!ctx->aborted) {
+    const int bound = best <= alphaStart ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+    search_tt_store(variant, key, symmetry, ply, remaining, best, bound, bestMove);
+  }
+  return best;
+}
+
+// Root moves shared out between the search threads. Threads take the next
+// unsearched move and publish its score, and the best two scores so far
+// give everyone the same alpha bound
+typedef struct {
+  MnkVariant variant;
+  const MnkBoard *board;
+  int player;
+  int maxDepth;
+  const int *moves;
+  int count;
+  int *scores;
+  bool *exact;  // False when the move failed low and its score is only an upper bound
+  double deadline;
+  SearchProgress *progress;
+  pthread_mutex_t lock;
+  int next;         // Next root move to hand out
+  int searched;     // Root moves with a score so far
+  int bestScore;    // Best two scores so far, in any move order
+  int secondScore;
+  bool aborted;
+  unsigned long long int nodes;
+  unsigned long long int ttProbes;
+  unsigned long long int ttHits;
+} RootSplit;
+
+static void search_root_task(void *arg, int thread, int threadCount) {
+  RootSplit *split = (RootSplit *)arg;
+  MnkBoard board = *split->board;  // Each thread searches its own copy
+  SearchContext ctx = {split->deadline, false, 0, split->progress};
+  (void)thread;
+  (void)threadCount;
+
+  while (true) {
+    pthread_mutex_lock(&split->lock);
+    if (split->aborted || split->next >= split->count) {
+      pthread_mutex_unlock(&split->lock);
+      break;
+    }
+    int i = split->next++;
+    int alpha = split->searched >= 2 ? split->secondScore - 1 : -SEARCH_INF;
+    pthread_mutex_unlock(&split->lock);
+
+    const int move = split->moves[i];
+    mnk_make_move(split->variant, &board, move, split->player);
+    int score = -mnk_negamax(&ctx, split->variant, &board, move, -split->player, 1,
+                             split->maxDepth, -SEARCH_INF, -alpha);
+    mnk_unmake_move(split->variant, &board, move);
+
+    pthread_mutex_lock(&split->lock);
+    if (ctx.aborted) {
+      split->aborted = true;
+    } else {
+      split->scores[i] = score;
+      split->exact[i] = score > alpha;
+      split->searched++;
+      if (score > split->bestScore) {
+        split->secondScore = split->bestScore;
+        split->bestScore = score;
+      } else if (score > split->secondScore) {
+        split->secondScore = score;
+      }
+    }
+    pthread_mutex_unlock(&split->lock);
+  }
+
+  pthread_mutex_lock(&split->lock);
+  split->nodes += ctx.nodes;
+  split->ttProbes += ctx.ttProbes;
+  split->ttHits += ctx.ttHits;
+  pthread_mutex_unlock(&split->lock);
+}
+
+int searchThreads = 0;
+static ThreadPool searchPool;
+static bool searchPoolReady = false;
+
+// Change the number of search threads, takes effect on the next search
+void search_set_threads(int threads) {
+  if (searchPoolReady && threads != searchThreads) {
+    threadpool_destroy(&searchPool);
+    searchPoolReady = false;
+  }
+  searchThreads = threads;
+}
+
+// The shared pool, started on first use. NULL when searching single threaded,
+// without touching the pool, so searches on several threads at once are safe then
+static ThreadPool *search_pool(void) {
+  if (searchThreads == 1) return NULL;
+  if (!searchPoolReady) {
+    threadpool_init(&searchPool, searchThreads);
+    searchPoolReady = true;
+  }
+  return searchPool.threadCount > 1 ? &searchPool : NULL;
+}
+
+// Search the given root moves and keep the best two, which mmAI needs for
+// its deliberate second-best picks. The moves are split across the threads
+// of ctx->pool. Once two scores are known the remaining moves are searched with
+// alpha just below the second one, so moves that cannot make the top two
+// fail low quickly while any move that can is scored exactly. Which moves
+// fail low, and their bounds, depend on the order the threads finish in,
+// so only exact scores pick the top two, and scores receives the exact
+// score of every move that ties or beats the second one and -SEARCH_INF
+// for the rest. The result and the next iteration's move order are then
+// the same as a full window search in move order, whatever the thread count.
+// Only touches ctx and the transposition table, so callers running their own
+// threads can search from each of them with a context whose pool is NULL
+SearchResult search_root_moves(SearchContext *ctx, MnkVariant variant, MnkBoard *board,
+                               int player, int maxDepth, const int *moves, int count,
+                               int *scores) {
+  SearchResult result = {-1, -SEARCH_INF, -1, -SEARCH_INF, maxDepth, 0};
+  bool exact[MNK_MAX_CELLS];
+  RootSplit split = {variant, board, player, maxDepth, moves, count, scores, exact,
+                     ctx->deadline, ctx->progress};
+  pthread_mutex_init(&split.lock, NULL);
+  split.bestScore = -SEARCH_INF;
+  split.secondScore = -SEARCH_INF;
+
+  if (ctx->pool != NULL)
+    threadpool_run(ctx->pool, search_root_task, &split);
+  else
+    search_root_task(&split, 0, 1);
+  pthread_mutex_destroy(&split.lock);
+
+  ctx->nodes += split.nodes;
+  ctx->ttProbes += split.ttProbes;
+  ctx->ttHits += split.ttHits;
+  ctx->aborted = split.aborted;
+  if (split.aborted) return result;
+
+  // Pick the top two in move order, ties go to the earlier move
+  for (int i = 0; i < count; i++) {
+    if (!exact[i]) continue;
+    if (scores[i] > result.bestScore) {
+      result.secondMove = result.bestMove;
+      result.secondScore = result.bestScore;
+      result.bestMove = moves[i];
+      result.bestScore = scores[i];
+    } else if (scores[i] > result.secondScore) {
+      result.secondMove = moves[i];
+      result.secondScore = scores[i];
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    if (!exact[i] || scores[i] < result.secondScore) scores[i] = -SEARCH_INF;
+  }
+  return result;
+}
+
+// Fixed depth search from the root
+SearchResult search_root(MnkVariant variant, MnkBoard *board, int player, int maxDepth) {
+  SearchContext ctx = {0, false, 0, NULL, search_pool()};
+  int moves[MNK_MAX_CELLS], scores[MNK_MAX_CELLS];
+  int count = mnk_candidate_moves(variant, board, moves);
+
+  SearchResult result =
+      search_root_moves(&ctx, variant, board, player, maxDepth, moves, count, scores);
+  result.nodes = ctx.nodes;
+  searchNodes += ctx.nodes;
+  ttProbes += ctx.ttProbes;
+  ttHits += ctx.ttHits;
+  return result;
+}
+
+// Iterative deepening: search depth 1, 2, 3... until budgetMs runs out or
+// maxDepth is reached, and return the last iteration that finished. Each
+// iteration visits the root moves best first by the previous scores, the
+// moves outside the top two keeping their order.
+// progress, if given, is updated as the search runs and can cancel it
+SearchResult search_iterative(MnkVariant variant, MnkBoard *board, int player, double budgetMs,
+                              int maxDepth, SearchProgress *progress) {
+  SearchContext ctx = {0, false, 0, progress, search_pool()};
+  int moves[MNK_MAX_CELLS], scores[MNK_MAX_CELLS];
+  int count = mnk_candidate_moves(variant, board, moves);
+  const int emptyCells = mnk_cells(variant) - board->moves;
+  const double start = search_now_ms();
+  SearchResult best = {-1, -SEARCH_INF, -1, -SEARCH_INF, 0, 0};
+
+  for (int depth = 1; depth <= maxDepth; depth++) {
+    // The first iteration always completes so there is a move to play
+    ctx.deadline = depth == 1 ? 0 : start + budgetMs;
+
+    SearchResult result =
+        search_root_moves(&ctx, variant, board, player, depth, moves, count, scores);
+    if (ctx.aborted) break;
+    best = result;
+    if (progress != NULL) atomic_store(&progress->depth, depth);
+
+    // Stable insertion sort of the root moves by score, best first
+    for (int i = 1; i < count; i++) {
+      int move = moves[i], score = scores[i], j = i - 1;
+      while (j >= 0 && scores[j] < score) {
+        moves[j + 1] = moves[j];
+        scores[j + 1] = scores[j];
+        j--;
+      }
+      moves[j + 1] = move;
+      scores[j + 1] = score;
+    }
+
+    // Stop early once the result is a proven win/loss or the tree is exhausted
+    if (best.bestScore > SEARCH_EVAL_LIMIT || best.bestScore < -SEARCH_EVAL_LIMIT) break;
+    if (depth >= emptyCells) break;
+    if (search_now_ms() - start >= budgetMs) break;
+  }
+
+  best.nodes = ctx.nodes;
+  searchNodes += ctx.nodes;
+  ttProbes += ctx.ttProbes;
+  ttHits += ctx.ttHits;
+  return best;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,414 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitboard.h"
+#include "ml_batch.h"
+#include "mlp.h"
+#include "packed_dataset.h"
+#include "search.h"
+#include "solver.h"
+#include "threadpool.h"
+
+// Self-play data generator for the 3x3 board. Games between the players of
+// a SelfPlayConfig run on every thread of a pool, and each position a move
+// is played from becomes one record: the cells, the move and the game's
+// outcome. Records go to disk in blocks as the games finish.
+//
+// File format: a PackedHeader with SELFPLAY_MAGIC, then one 32 bit word per
+// position. Cells take bits 0-17 as in packed_dataset.h, the move bits
+// 18-21 and the outcome bits 22-23 (0 draw, 1 X won, 2 O won). The side to
+// move follows from the piece counts, X always opens.
+//
+// Every game draws its players and moves from its own random stream, seeded
+// from SelfPlayConfig.seed and the game's number, so the same games are
+// played whatever the thread count; only the record order changes.
+#define SELFPLAY_MAGIC 0x53545454u  // "TTTS"
+#define SELFPLAY_VERSION 1
+#define SELFPLAY_MOVE_SHIFT 18
+#define SELFPLAY_OUTCOME_SHIFT 22
+#define SELFPLAY_MAX_DEPTH BB_CELLS
+#define SELFPLAY_CHUNK 64           // Games a thread claims at a time
+#define SELFPLAY_BUFFER (1 << 16)   // Records a thread collects before writing them
+
+typedef enum {
+  SELFPLAY_RANDOM,   // Uniform over the empty cells
+  SELFPLAY_MINIMAX,  // search.h root search to a fixed depth, as the IMPOSSIBLE bot runs it
+  SELFPLAY_PERFECT,  // The solver's perfect-play table
+  SELFPLAY_ML,       // Linear model, best value for the side to move
+  SELFPLAY_MLP,      // Int8 MLP with its reply lookahead
+} SelfPlayKind;
+
+typedef struct {
+  SelfPlayKind kind;
+  int depth;          // Plies searched by SELFPLAY_MINIMAX
+  int secondPercent;  // Chance of playing the second best move, mmAI plays it 30% of the time
+} SelfPlayer;
+
+typedef struct {
+  const SelfPlayer *players;  // X and O are both drawn from these every game
+  int playerCount;
+  const double *weights;  // Linear model, only read by SELFPLAY_ML
+  const MlpInt8 *mlp;     // Only read by SELFPLAY_MLP
+  long long games;
+  uint64_t seed;
+} SelfPlayConfig;
+
+typedef struct {
+  long long games;
+  long long positions;
+  long long outcomes[3];  // Draws, X wins, O wins
+  double ms;
+} SelfPlayStats;
+
+// Random stream of game number game
+static inline uint64_t selfplay_seed(uint64_t seed, long long game) {
+  return seed ^ (uint64_t)game * 0xD1B54A32D192ED03ULL;
+}
+
+// function prototypes
+bool selfplay_parse_player(const char *spec, SelfPlayer *player);
+void selfplay_player_name(SelfPlayer player, char *out, int size);
+uint32_t selfplay_record(Bitboard board, int move, int winner);
+void selfplay_unpack(uint32_t record, Bitboard *board, int *move, int *winner);
+int selfplay_move(const SelfPlayConfig *config, SelfPlayer player, Bitboard board, int side,
+                  uint64_t *rng);
+int selfplay_play(const SelfPlayConfig *config, const SelfPlayer players[2], uint64_t *rng,
+                  uint32_t *records, int *count);
+int selfplay_game(const SelfPlayConfig *config, long long game, uint32_t *records, int *count);
+bool selfplay_run(const SelfPlayConfig *config, const char *filename, int threads,
+                  SelfPlayStats *stats);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// "random", "perfect", "ml", "mlp" or "minimax:N" with N from 1 to 9,
+// optionally followed by "/P" to play the second best move P% of the time
+bool selfplay_parse_player(const char *spec, SelfPlayer *player) {
+  char name[32];
+  const char *slash = strchr(spec, '/');
+  const size_t length = slash != NULL ? (size_t)(slash - spec) : strlen(spec);
+  if (length >= sizeof(name)) return false;
+  memcpy(name, spec, length);
+  name[length] = '\0';
+
+  player->depth = 0;
+  player->secondPercent = 0;
+  if (slash != NULL) {
+    char *end;
+    const long percent = strtol(slash + 1, &end, 10);
+    if (end == slash + 1 || *end != '\0' || percent < 0 || percent > 100) return false;
+    player->secondPercent = (int)percent;
+  }
+
+  if (strcmp(name, "random") == 0) player->kind = SELFPLAY_RANDOM;
+  else if (strcmp(name, "perfect") == 0) player->kind = SELFPLAY_PERFECT;
+  else if (strcmp(name, "ml") == 0) player->kind = SELFPLAY_ML;
+  else if (strcmp(name, "mlp") == 0) player->kind = SELFPLAY_MLP;
+  else if (strncmp(name, "minimax:", 8) == 0) {
+    char *end;
+    const long depth = strtol(name + 8, &end, 10);
+    if (end == name + 8 || *end != '\0' || depth < 1 || depth > SELFPLAY_MAX_DEPTH) return false;
+    player->kind = SELFPLAY_MINIMAX;
+    player->depth = (int)depth;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The spec selfplay_parse_player reads back
+void selfplay_player_name(SelfPlayer player, char *out, int size) {
+  static const char *NAMES[] = {"random", "minimax", "perfect", "ml", "mlp"};
+  char percent[8] = "";
+  if (player.secondPercent) snprintf(percent, sizeof(percent), "/%d", player.secondPercent);
+  if (player.kind == SELFPLAY_MINIMAX) snprintf(out, size, "minimax:%d%s", player.depth, percent);
+  else snprintf(out, size, "%s%s", NAMES[player.kind], percent);
+}
+
+uint32_t selfplay_record(Bitboard board, int move, int winner) {
+  int8_t cells[BB_CELLS];
+  for (int i = 0; i < BB_CELLS; i++) cells[i] = (int8_t)bb_cell(board, i);
+  const uint32_t outcome = winner == X ? 1 : winner == O ? 2 : 0;
+  return packed_row(cells, BB_CELLS, 0) | (uint32_t)move << SELFPLAY_MOVE_SHIFT |
+         outcome << SELFPLAY_OUTCOME_SHIFT;
+}
+
+// Reverse of selfplay_record, winner is X, O or EMPTY for a draw
+void selfplay_unpack(uint32_t record, Bitboard *board, int *move, int *winner) {
+  board->x = board->o = 0;
+  for (int i = 0; i < BB_CELLS; i++) {
+    const uint32_t code = (record >> (2 * i)) & 3;
+    if (code == 1) board->x |= (BBMask)(1u << i);
+    if (code == 2) board->o |= (BBMask)(1u << i);
+  }
+  *move = (record >> SELFPLAY_MOVE_SHIFT) & 15;
+  const uint32_t outcome = (record >> SELFPLAY_OUTCOME_SHIFT) & 3;
+  *winner = outcome == 1 ? X : outcome == 2 ? O : EMPTY;
+}
+
+// splitmix64 step, one stream per game
+static uint64_t selfplay_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Pick the best of scores[] over moves, ties broken at random
+static int selfplay_best(BBMask moves, const double scores[BB_CELLS], uint64_t *rng) {
+  int best = -1, ties = 0;
+  while (moves) {
+    const int cell = bb_pop_lsb(&moves);
+    if (best == -1 || scores[cell] > scores[best]) {
+      best = cell;
+      ties = 1;
+    } else if (scores[cell] == scores[best] && selfplay_random(rng) % ++ties == 0) {
+      best = cell;
+    }
+  }
+  return best;
+}
+
+// The best move, or secondPercent of the time the best of the others
+static int selfplay_pick(BBMask moves, const double scores[BB_CELLS], int secondPercent,
+                         uint64_t *rng) {
+  const int best = selfplay_best(moves, scores, rng);
+  const BBMask others = (BBMask)(moves & ~(1u << best));
+  if (secondPercent == 0 || others == 0 || (int)(selfplay_random(rng) % 100) >= secondPercent) {
+    return best;
+  }
+  return selfplay_best(others, scores, rng);
+}
+
+// Move of player for side on an unfinished board
+int selfplay_move(const SelfPlayConfig *config, SelfPlayer player, Bitboard board, int side,
+                  uint64_t *rng) {
+  const BBMask empty = bb_empty(board);
+  double scores[BB_CELLS] = {0};
+
+  switch (player.kind) {
+    case SELFPLAY_RANDOM: {
+      BBMask moves = empty;
+      int skip = (int)(selfplay_random(rng) % bb_popcount(moves));
+      while (skip--) bb_pop_lsb(&moves);
+      return bb_pop_lsb(&moves);
+    }
+    case SELFPLAY_PERFECT: {
+      // Every move keeping the table's score is perfect, so pick among them
+      BBMask moves = empty;
+      while (moves) {
+        const int cell = bb_pop_lsb(&moves);
+        bb_make_move(&board, cell, side);
+        scores[cell] = -solver_score(board);
+        bb_unmake_move(&board, cell);
+      }
+      break;
+    }
+    case SELFPLAY_MINIMAX: {
+      // The exact best and second best moves of the root search, on this
+      // thread, and the second one secondPercent of the time like mmAI
+      const MnkVariant classic = MNK_PRESETS[0];
+      MnkBoard mnk;
+      mnk_from_bitboard(&mnk, board);
+      int moves[MNK_MAX_CELLS], values[MNK_MAX_CELLS];
+      const int count = mnk_candidate_moves(classic, &mnk, moves);
+      SearchContext ctx = {0, false, 0, NULL, NULL};
+      const SearchResult result =
+          search_root_moves(&ctx, classic, &mnk, side, player.depth, moves, count, values);
+      if (result.secondMove != -1 && player.secondPercent > 0 &&
+          (int)(selfplay_random(rng) % 100) < player.secondPercent) {
+        return result.secondMove;
+      }
+      return result.bestMove;
+    }
+    case SELFPLAY_ML: {
+      // The model predicts "X wins", so O plays the lowest value
+      ml_score_moves(board, side, config->weights, scores);
+      if (side == O) {
+        for (int i = 0; i < BB_CELLS; i++) scores[i] = -scores[i];
+      }
+      break;
+    }
+    case SELFPLAY_MLP: {
+      int32_t logits[BB_CELLS];
+      BBMask moves = mlp_int8_score_moves(config->mlp, board, side, logits);
+      while (moves) {
+        const int cell = bb_pop_lsb(&moves);
+        scores[cell] = logits[cell];
+      }
+      break;
+    }
+  }
+  return selfplay_pick(empty, scores, player.secondPercent, rng);
+}
+
+// Play one game of players[0] (X) against players[1] (O). When records is
+// not NULL it gets one record per move (room for BB_CELLS) and count their
+// number. Returns the winner, EMPTY for a draw
+int selfplay_play(const SelfPlayConfig *config, const SelfPlayer players[2], uint64_t *rng,
+                  uint32_t *records, int *count) {
+  Bitboard board = {0, 0};
+  Bitboard history[BB_CELLS];
+  int moves[BB_CELLS];
+  int side = X;
+  int winner = EMPTY;
+  int played = 0;
+  while (bb_empty(board)) {
+    const int move = selfplay_move(config, players[side == O], board, side, rng);
+    history[played] = board;
+    moves[played++] = move;
+    bb_make_move(&board, move, side);
+    if (bb_has_line(side == X ? board.x : board.o)) {
+      winner = side;
+      break;
+    }
+    side = -side;
+  }
+
+  if (records != NULL) {
+    for (int i = 0; i < played; i++) records[i] = selfplay_record(history[i], moves[i], winner);
+    *count = played;
+  }
+  return winner;
+}
+
+// Play game number game of config between two players drawn from it
+int selfplay_game(const SelfPlayConfig *config, long long game, uint32_t *records, int *count) {
+  uint64_t rng = selfplay_seed(config->seed, game);
+  const SelfPlayer players[2] = {
+      config->players[selfplay_random(&rng) % config->playerCount],  // X
+      config->players[selfplay_random(&rng) % config->playerCount],  // O
+  };
+  return selfplay_play(config, players, &rng, records, count);
+}
+
+// Output file shared by the threads of selfplay_run, written through a
+// temporary file like packed_write
+typedef struct {
+  FILE *file;
+  pthread_mutex_t lock;
+  PackedHeader header;
+  bool failed;
+} SelfPlayWriter;
+
+static void selfplay_write(SelfPlayWriter *writer, const uint32_t *records, size_t count) {
+  pthread_mutex_lock(&writer->lock);
+  if (!writer->failed) {
+    writer->header.checksum = packed_checksum(writer->header.checksum, records, count);
+    writer->header.rowCount += count;
+    writer->failed = fwrite(records, sizeof(uint32_t), count, writer->file) != count;
+  }
+  pthread_mutex_unlock(&writer->lock);
+}
+
+typedef struct {
+  const SelfPlayConfig *config;
+  SelfPlayWriter *writer;
+  atomic_llong nextGame;
+  SelfPlayStats *threadStats;  // One per thread, summed once the run is done
+} SelfPlayJob;
+
+// Claim games a chunk at a time and write their records a buffer at a time
+static void selfplay_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  SelfPlayJob *job = (SelfPlayJob *)arg;
+  SelfPlayStats *stats = &job->threadStats[thread];
+  uint32_t *buffer = malloc(sizeof(uint32_t) * SELFPLAY_BUFFER);
+  if (buffer == NULL) {
+    pthread_mutex_lock(&job->writer->lock);
+    job->writer->failed = true;
+    pthread_mutex_unlock(&job->writer->lock);
+    return;
+  }
+  size_t used = 0;
+
+  while (true) {
+    const long long begin = atomic_fetch_add(&job->nextGame, SELFPLAY_CHUNK);
+    if (begin >= job->config->games) break;
+    const long long end =
+        begin + SELFPLAY_CHUNK < job->config->games ? begin + SELFPLAY_CHUNK : job->config->games;
+
+    for (long long game = begin; game < end; game++) {
+      if (used + BB_CELLS > SELFPLAY_BUFFER) {
+        selfplay_write(job->writer, buffer, used);
+        used = 0;
+      }
+      int count;
+      const int winner = selfplay_game(job->config, game, buffer + used, &count);
+      used += count;
+      stats->games++;
+      stats->positions += count;
+      stats->outcomes[winner == X ? 1 : winner == O ? 2 : 0]++;
+    }
+  }
+  if (used) selfplay_write(job->writer, buffer, used);
+  free(buffer);
+}
+
+// Play config->games games on threads threads and write their records to
+// filename. stats gets the totals and the wall-clock time, disk included.
+// Returns false when the file cannot be written
+bool selfplay_run(const SelfPlayConfig *config, const char *filename, int threads,
+                  SelfPlayStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  solver_init();  // Read-only once built, so the threads can share it
+
+  char temp[512];
+  snprintf(temp, sizeof(temp), "%s.tmp", filename);
+  SelfPlayWriter writer = {.header = {SELFPLAY_MAGIC, SELFPLAY_VERSION, BB_CELLS, 0, 0,
+                                      14695981039346656037ull}};
+  writer.file = fopen(temp, "wb");
+  if (writer.file == NULL) return false;
+  pthread_mutex_init(&writer.lock, NULL);
+  writer.failed = fwrite(&writer.header, sizeof(writer.header), 1, writer.file) != 1;
+
+  SelfPlayJob job = {config, &writer, 0, calloc(threads, sizeof(SelfPlayStats))};
+  const double start = search_now_ms();
+  if (job.threadStats == NULL) {
+    writer.failed = true;
+  } else if (threads > 1) {
+    ThreadPool pool;
+    if (threadpool_init(&pool, threads)) {
+      threadpool_run(&pool, selfplay_task, &job);
+      threadpool_destroy(&pool);
+    } else {
+      writer.failed = true;
+    }
+  } else {
+    selfplay_task(&job, 0, 1);
+  }
+
+  // The header goes back in front of the rows with the final count and checksum
+  if (!writer.failed) {
+    writer.failed = fseek(writer.file, 0, SEEK_SET) != 0 ||
+                    fwrite(&writer.header, sizeof(writer.header), 1, writer.file) != 1;
+  }
+  if (fclose(writer.file) != 0) writer.failed = true;
+  stats->ms = search_now_ms() - start;
+  pthread_mutex_destroy(&writer.lock);
+
+  for (int t = 0; job.threadStats != NULL && t < threads; t++) {
+    stats->games += job.threadStats[t].games;
+    stats->positions += job.threadStats[t].positions;
+    for (int o = 0; o < 3; o++) stats->outcomes[o] += job.threadStats[t].outcomes[o];
+  }
+  free(job.threadStats);
+
+  if (writer.failed) {
+    remove(temp);
+    return false;
+  }
+  remove(filename);  // rename does not replace an existing file on Windows
+  return rename(temp, filename) == 0;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Instruction sets the batch and training kernels are written for, and the
+// check for the widest one this CPU runs. x86-64 always has SSE2 and gets
+// AVX2 when the CPU reports both AVX2 and FMA, which every AVX2 CPU but a
+// few early VIA ones does, ARM gets NEON, anything else the scalar loops.
+// Kernels for a wider set than the build default carry
+// __attribute__((target)), so no extra compiler flags are needed.
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef enum { SIMD_SCALAR,
+               SIMD_SSE2,
+               SIMD_AVX2,
+               SIMD_NEON } SimdLevel;
+
+// function prototypes
+SimdLevel simd_level(void);
+const char *simd_level_name(SimdLevel level);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Widest instruction set the batch kernels can use here
+SimdLevel simd_level(void) {
+#if defined(SIMD_X86)
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? SIMD_AVX2 : SIMD_SSE2;
+#elif defined(SIMD_NEON)
+  return SIMD_NEON;
+#else
+  return SIMD_SCALAR;
+#endif
+}
+
+const char *simd_level_name(SimdLevel level) {
+  static const char *NAMES[] = {"scalar", "sse2", "avx2", "neon"};
+  return NAMES[level];
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
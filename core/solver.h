@@ -0,0 +1,120 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bitboard.h"
+
+#define SOLVER_STATES 19683  // 3^9 board encodings
+#define SOLVER_WIN 10        // Score of an immediate win, minus one per extra ply
+#define SOLVER_UNKNOWN INT8_MIN
+
+// Perfect-play table for the whole 3x3 game, indexed by the base 3 encoding
+// of the board. Scores are from the point of view of the side to move:
+// SOLVER_WIN - plies for a forced win, the negation for a forced loss, 0 for a draw.
+typedef struct {
+  int8_t score[SOLVER_STATES];
+  int8_t bestMove[SOLVER_STATES];  // -1 on finished positions
+  int positions;                   // Reachable positions found
+} SolverTable;
+
+// function prototypes
+void solver_init(void);
+int solver_index(Bitboard board);
+int solver_side_to_move(Bitboard board);
+int solver_score(Bitboard board);
+int solver_best_move(Bitboard board);
+int solver_value(Bitboard board);
+
+extern SolverTable solverTable;  // Filled by solver_init
+
+#ifdef ENGINE_IMPLEMENTATION
+
+SolverTable solverTable;
+static bool solverReady = false;
+static uint16_t solverPow3[1 << BB_CELLS];  // Sum of 3^cell over the set cells
+
+// Base 3 index of a board: 0 = empty, 1 = X, 2 = O per cell
+int solver_index(Bitboard board) { return solverPow3[board.x] + 2 * solverPow3[board.o]; }
+
+// X always opens, so equal piece counts mean X is to move
+int solver_side_to_move(Bitboard board) {
+  return bb_popcount(board.x) == bb_popcount(board.o) ? X : O;
+}
+
+// Negamax over every reachable position, each one solved exactly once
+static int solver_solve(Bitboard *board) {
+  int index = solver_index(*board);
+  if (solverTable.score[index] != SOLVER_UNKNOWN) return solverTable.score[index];
+
+  int player = solver_side_to_move(*board);
+  int score;
+  int bestMove = -1;
+  solverTable.positions++;
+
+  // The previous move can only have completed a line for the opponent
+  if (bb_has_line(player == X ? board->o : board->x)) {
+    score = -SOLVER_WIN;
+  } else if (bb_empty(*board) == 0) {
+    score = 0;
+  } else {
+    score = -SOLVER_WIN - 1;
+    BBMask moves = bb_empty(*board);
+    while (moves) {
+      int cell = bb_pop_lsb(&moves);
+      bb_make_move(board, cell, player);
+      int value = -solver_solve(board);
+      bb_unmake_move(board, cell);
+
+      // Step one ply closer to zero so quicker wins and slower losses rank higher
+      if (value > 0) value--;
+      if (value < 0) value++;
+      if (value > score) {
+        score = value;
+        bestMove = cell;
+      }
+    }
+  }
+
+  solverTable.score[index] = (int8_t)score;
+  solverTable.bestMove[index] = (int8_t)bestMove;
+  return score;
+}
+
+// Enumerate the full game once, later calls return immediately
+void solver_init(void) {
+  if (solverReady) return;
+
+  for (int mask = 0; mask < (1 << BB_CELLS); mask++) {
+    int sum = 0, pow3 = 1;
+    for (int cell = 0; cell < BB_CELLS; cell++, pow3 *= 3) {
+      if (mask & (1 << cell)) sum += pow3;
+    }
+    solverPow3[mask] = (uint16_t)sum;
+  }
+
+  memset(solverTable.score, SOLVER_UNKNOWN, sizeof(solverTable.score));
+  memset(solverTable.bestMove, -1, sizeof(solverTable.bestMove));
+  solverTable.positions = 0;
+
+  Bitboard board = {0, 0};
+  solver_solve(&board);
+  solverReady = true;
+}
+
+// Score for the side to move, SOLVER_UNKNOWN if the position is unreachable
+int solver_score(Bitboard board) { return solverTable.score[solver_index(board)]; }
+
+int solver_best_move(Bitboard board) { return solverTable.bestMove[solver_index(board)]; }
+
+// Game-theoretic outcome for the side to move: 1 win, 0 draw, -1 loss
+int solver_value(Bitboard board) {
+  int score = solver_score(board);
+  return (score > 0) - (score < 0);
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
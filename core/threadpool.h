@@ -0,0 +1,138 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+// Fork/join thread pool: threadpool_run hands the same task to every thread
+// (the calling thread included) and returns once all of them finished.
+// Tasks split their work using the thread index they are given.
+typedef void (*ThreadTask)(void *arg, int thread, int threadCount);
+
+typedef struct {
+  pthread_t *workers;  // threadCount - 1 helper threads
+  int threadCount;     // Helpers plus the calling thread
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t finished;
+  ThreadTask task;
+  void *arg;
+  unsigned long generation;  // Bumped for every task handed out
+  int busy;                  // Helpers still working on the current task
+  bool shutdown;
+} ThreadPool;
+
+// function prototypes
+int threadpool_cpu_count(void);
+bool threadpool_init(ThreadPool *pool, int threadCount);
+void threadpool_run(ThreadPool *pool, ThreadTask task, void *arg);
+void threadpool_destroy(ThreadPool *pool);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Number of online CPU cores, at least 1
+int threadpool_cpu_count(void) {
+#if defined(_WIN32)
+  int count = pthread_num_processors_np();
+#else
+  int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return count > 0 ? count : 1;
+}
+
+typedef struct {
+  ThreadPool *pool;
+  int index;
+} ThreadPoolWorker;
+
+static void *threadpool_worker(void *data) {
+  ThreadPoolWorker *worker = (ThreadPoolWorker *)data;
+  ThreadPool *pool = worker->pool;
+  const int index = worker->index;
+  unsigned long seen = 0;
+  free(worker);
+
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (!pool->shutdown && pool->generation == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+    if (pool->shutdown) break;
+    seen = pool->generation;
+    ThreadTask task = pool->task;
+    void *arg = pool->arg;
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, index, pool->threadCount);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->busy == 0) pthread_cond_signal(&pool->finished);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+// Start threadCount - 1 helper threads, 0 or less means one per core
+bool threadpool_init(ThreadPool *pool, int threadCount) {
+  if (threadCount <= 0) threadCount = threadpool_cpu_count();
+
+  pool->threadCount = 1;
+  pool->generation = 0;
+  pool->busy = 0;
+  pool->shutdown = false;
+  pool->workers = threadCount > 1 ? malloc(sizeof(pthread_t) * (threadCount - 1)) : NULL;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+
+  for (int i = 1; i < threadCount && pool->workers != NULL; i++) {
+    ThreadPoolWorker *worker = malloc(sizeof(ThreadPoolWorker));
+    if (worker == NULL) break;
+    worker->pool = pool;
+    worker->index = i;
+    if (pthread_create(&pool->workers[i - 1], NULL, threadpool_worker, worker) != 0) {
+      free(worker);
+      break;
+    }
+    pool->threadCount++;
+  }
+  return pool->threadCount == threadCount;
+}
+
+// Run task on every thread of the pool and wait for all of them
+void threadpool_run(ThreadPool *pool, ThreadTask task, void *arg) {
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->arg = arg;
+  pool->busy = pool->threadCount - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  task(arg, 0, pool->threadCount);  // The caller is thread 0
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->busy > 0) pthread_cond_wait(&pool->finished, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_destroy(ThreadPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->threadCount - 1; i++) pthread_join(pool->workers[i], NULL);
+  free(pool->workers);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->finished);
+  pool->workers = NULL;
+  pool->threadCount = 1;
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aiworker.h"
+#include "mcts_engine.h"
+#include "minimax_engine.h"
+#include "ml_engine.h"
+#include "mnk.h"
+#include "search.h"
+#include "solver.h"
+#include "threadpool.h"
+
+// Round-robin tournaments between the game's bots on any m,n,k variant.
+// Every pair of players meets gamesPerPair times with colours alternating,
+// and the games run on every thread of a pool. The players are the GUI's
+// worker jobs (mm_ai_job, ml_ai_job, mcts_ai_job) called the way the GUI
+// calls them, randomisation included, so a table rates the bots people
+// actually play. Like in the GUI they draw from rand() and the minimax
+// search is timed, so tables vary a little from run to run.
+//
+// Ratings are maximum likelihood Elo under the Bradley-Terry model with
+// draws as half a point, centred on the field's average. One virtual draw
+// per pairing keeps them finite when a player wins or loses every game.
+// Margins are 95% intervals from the Fisher information of each rating.
+#define TOURNAMENT_MAX_PLAYERS 16
+#define TOURNAMENT_CHUNK 4        // Games a thread claims at a time
+#define TOURNAMENT_Z 1.96         // 95% confidence
+#define TOURNAMENT_ITERATIONS 1000
+#define TOURNAMENT_SECOND_PERCENT 30  // mmAI's chance of the second best move
+
+typedef enum {
+  TOURNAMENT_RANDOM,   // Uniform over the empty cells, a baseline
+  TOURNAMENT_MINIMAX,  // mm_ai_job, the IMPOSSIBLE bot
+  TOURNAMENT_ML,       // ml_ai_job with the linear model, the NORMAL bot
+  TOURNAMENT_MLP,      // ml_ai_job with the int8 MLP, the NORMAL bot with --model mlp
+  TOURNAMENT_MCTS,     // mcts_ai_job, the MONTE_CARLO bot
+} TournamentKind;
+
+typedef struct {
+  TournamentKind kind;
+  int secondPercent;  // Chance TOURNAMENT_MINIMAX plays the second best move
+  int playouts;       // TOURNAMENT_MCTS budget per move, 0 for MCTS_PLAYOUTS like the GUI
+} TournamentPlayer;
+
+typedef struct {
+  MnkVariant variant;
+  const TournamentPlayer *players;
+  int playerCount;
+  const MLModel *linear;  // Only read by TOURNAMENT_ML
+  const MLModel *mlp;     // Only read by TOURNAMENT_MLP
+} TournamentConfig;
+
+typedef struct {
+  long long wins;
+  long long draws;
+  long long losses;
+} TournamentScore;
+
+typedef struct {
+  int playerCount;
+  long long games;
+  TournamentScore score[TOURNAMENT_MAX_PLAYERS][TOURNAMENT_MAX_PLAYERS];  // Row against column
+  double ms;
+} TournamentTable;
+
+// function prototypes
+bool tournament_parse_player(const char *spec, TournamentPlayer *player);
+void tournament_player_name(TournamentPlayer player, char *out, int size);
+int tournament_move(const TournamentConfig *config, TournamentPlayer player,
+                    const MnkBoard *board, int side, MctsTree *tree);
+int tournament_play(const TournamentConfig *config, const TournamentPlayer players[2],
+                    MctsTree trees[2]);
+bool tournament_run(const TournamentConfig *config, long long gamesPerPair, int threads,
+                    TournamentTable *table);
+void tournament_pair_elo(TournamentScore score, double *elo, double *margin);
+void tournament_ratings(const TournamentTable *table, double *elo, double *margin);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Parse "random", "minimax", "ml", "mlp" or "mcts". minimax may be followed
+// by /P to play the second best move P% of the time instead of 30%, mcts by
+// :N for N playouts per move
+bool tournament_parse_player(const char *spec, TournamentPlayer *player) {
+  char name[16];
+  int length = (int)strcspn(spec, ":/");
+  if (length >= (int)sizeof(name)) return false;
+  memcpy(name, spec, length);
+  name[length] = '\0';
+
+  player->secondPercent = 0;
+  player->playouts = 0;
+  if (strcmp(name, "random") == 0) player->kind = TOURNAMENT_RANDOM;
+  else if (strcmp(name, "ml") == 0) player->kind = TOURNAMENT_ML;
+  else if (strcmp(name, "mlp") == 0) player->kind = TOURNAMENT_MLP;
+  else if (strcmp(name, "minimax") == 0) player->kind = TOURNAMENT_MINIMAX;
+  else if (strcmp(name, "mcts") == 0) player->kind = TOURNAMENT_MCTS;
+  else return false;
+
+  const char *rest = spec + length;
+  if (player->kind == TOURNAMENT_MINIMAX) {
+    player->secondPercent = TOURNAMENT_SECOND_PERCENT;
+    if (*rest == '/') {
+      char *end;
+      player->secondPercent = (int)strtol(rest + 1, &end, 10);
+      if (end == rest + 1 || player->secondPercent < 0 || player->secondPercent > 100) return false;
+      rest = end;
+    }
+  } else if (player->kind == TOURNAMENT_MCTS && *rest == ':') {
+    char *end;
+    player->playouts = (int)strtol(rest + 1, &end, 10);
+    if (end == rest + 1 || player->playouts < 1) return false;
+    rest = end;
+  }
+  return *rest == '\0';
+}
+
+void tournament_player_name(TournamentPlayer player, char *out, int size) {
+  static const char *names[] = {"random", "minimax", "ml", "mlp", "mcts"};
+  if (player.kind == TOURNAMENT_MINIMAX) {
+    snprintf(out, size, "%s/%d", names[player.kind], player.secondPercent);
+  } else if (player.kind == TOURNAMENT_MCTS && player.playouts > 0) {
+    snprintf(out, size, "%s:%d", names[player.kind], player.playouts);
+  } else {
+    snprintf(out, size, "%s", names[player.kind]);
+  }
+}
+
+// Move player picks for side. tree is the player's own MCTS tree, kept
+// between its moves like the GUI keeps mctsTree
+int tournament_move(const TournamentConfig *config, TournamentPlayer player,
+                    const MnkBoard *board, int side, MctsTree *tree) {
+  AIJob job = {NULL, config->variant, *board, side, NULL};
+
+  switch (player.kind) {
+    case TOURNAMENT_RANDOM: {
+      int moves[MNK_MAX_CELLS], count = 0;
+      for (int w = 0; w < MNK_WORDS; w++) {
+        uint64_t empty = mnk_empty_word(config->variant, board, w);
+        while (empty) moves[count++] = mnk_pop_lsb(&empty, w);
+      }
+      return moves[getRandom(0, count - 1)];
+    }
+    case TOURNAMENT_MINIMAX: {
+      // The second best move secondPercent of the time, as mmAI picks it
+      const SearchResult result = mm_ai_job(&job, NULL);
+      if (result.secondMove != -1 && getRandom(1, 100) <= player.secondPercent) {
+        return result.secondMove;
+      }
+      return result.bestMove;
+    }
+    case TOURNAMENT_ML:
+    case TOURNAMENT_MLP:
+      job.engine = player.kind == TOURNAMENT_ML ? config->linear : config->mlp;
+      return ml_ai_job(&job, NULL).bestMove;
+    case TOURNAMENT_MCTS:
+      tree->playouts = player.playouts;
+      job.engine = tree;
+      return mcts_ai_job(&job, NULL).bestMove;
+  }
+  return -1;
+}
+
+// Play one game of players[0] (X) against players[1] (O), trees holding
+// their MCTS trees. Returns the winner, EMPTY for a draw
+int tournament_play(const TournamentConfig *config, const TournamentPlayer players[2],
+                    MctsTree trees[2]) {
+  MnkBoard board;
+  mnk_clear(&board);
+  int side = X;
+
+  while (!mnk_is_full(config->variant, &board)) {
+    const int seat = side == X ? 0 : 1;
+    const int move = tournament_move(config, players[seat], &board, side, &trees[seat]);
+    if (move >= 0) {  // No move is a pass, as the GUI hands the turn back then
+      mnk_make_move(config->variant, &board, move, side);
+      if (mnk_is_win_at(config->variant, &board, move)) return side;
+    }
+    side = -side;
+  }
+  return EMPTY;
+}
+
+typedef struct {
+  const TournamentConfig *config;
+  long long gamesPerPair;
+  int pairs[TOURNAMENT_MAX_PLAYERS * TOURNAMENT_MAX_PLAYERS][2];
+  long long games;
+  atomic_llong nextGame;
+  TournamentTable *threadTables;  // One per thread, summed once the run is done
+  MctsTree *trees;                // Two per thread, one for each seat
+} TournamentJob;
+
+static void tournament_task(void *arg, int thread, int threadCount) {
+  (void)threadCount;
+  TournamentJob *job = (TournamentJob *)arg;
+  TournamentTable *table = &job->threadTables[thread];
+
+  while (true) {
+    const long long begin = atomic_fetch_add(&job->nextGame, TOURNAMENT_CHUNK);
+    if (begin >= job->games) break;
+    const long long end =
+        begin + TOURNAMENT_CHUNK < job->games ? begin + TOURNAMENT_CHUNK : job->games;
+
+    for (long long game = begin; game < end; game++) {
+      // The pair's first player takes X in even games and O in odd ones
+      const int *pair = job->pairs[game / job->gamesPerPair];
+      const int first = game % job->gamesPerPair % 2 == 0 ? pair[0] : pair[1];
+      const int second = first == pair[0] ? pair[1] : pair[0];
+      const TournamentPlayer players[2] = {job->config->players[first],
+                                           job->config->players[second]};
+
+      const int winner = tournament_play(job->config, players, &job->trees[2 * thread]);
+      if (winner == EMPTY) {
+        table->score[first][second].draws++;
+        table->score[second][first].draws++;
+      } else {
+        const int won = winner == X ? first : second;
+        const int lost = winner == X ? second : first;
+        table->score[won][lost].wins++;
+        table->score[lost][won].losses++;
+      }
+    }
+  }
+}
+
+// Play every pair of config's players gamesPerPair times on threads
+// threads. With more than one the searches inside the games run single
+// threaded, the games already keep every core busy. Returns false when the
+// threads cannot be started or there are too many players
+bool tournament_run(const TournamentConfig *config, long long gamesPerPair, int threads,
+                    TournamentTable *table) {
+  memset(table, 0, sizeof(*table));
+  if (config->playerCount > TOURNAMENT_MAX_PLAYERS) return false;
+  if (mnk_is_classic(config->variant)) solver_init();  // mm_ai_job's table, read-only once built
+
+  TournamentJob *job = calloc(1, sizeof(TournamentJob));
+  if (job == NULL) return false;
+  job->config = config;
+  job->gamesPerPair = gamesPerPair;
+  int pairCount = 0;
+  for (int i = 0; i < config->playerCount; i++) {
+    for (int j = i + 1; j < config->playerCount; j++) {
+      job->pairs[pairCount][0] = i;
+      job->pairs[pairCount++][1] = j;
+    }
+  }
+  job->games = pairCount * gamesPerPair;
+  job->threadTables = calloc(threads, sizeof(TournamentTable));
+  job->trees = calloc(2 * threads, sizeof(MctsTree));  // Nodes are allocated on first search
+
+  bool ok = job->threadTables != NULL && job->trees != NULL;
+  const int searchThreadsBefore = searchThreads;
+  const double start = search_now_ms();
+  if (ok && threads > 1) {
+    ThreadPool pool;
+    ok = threadpool_init(&pool, threads);
+    if (ok) {
+      search_set_threads(1);
+      threadpool_run(&pool, tournament_task, job);
+      threadpool_destroy(&pool);
+      search_set_threads(searchThreadsBefore);
+    }
+  } else if (ok) {
+    tournament_task(job, 0, 1);
+  }
+  table->ms = search_now_ms() - start;
+
+  table->playerCount = config->playerCount;
+  table->games = ok ? job->games : 0;
+  for (int t = 0; ok && t < threads; t++) {
+    for (int i = 0; i < config->playerCount; i++) {
+      for (int j = 0; j < config->playerCount; j++) {
+        table->score[i][j].wins += job->threadTables[t].score[i][j].wins;
+        table->score[i][j].draws += job->threadTables[t].score[i][j].draws;
+        table->score[i][j].losses += job->threadTables[t].score[i][j].losses;
+      }
+    }
+  }
+  for (int t = 0; job->trees != NULL && t < 2 * threads; t++) mcts_free(&job->trees[t]);
+  free(job->trees);
+  free(job->threadTables);
+  free(job);
+  return ok;
+}
+
+// Elo difference score implies and its 95% margin, from the spread of the
+// game results. Infinite when one side scored every point
+void tournament_pair_elo(TournamentScore score, double *elo, double *margin) {
+  const double games = score.wins + score.draws + score.losses;
+  *elo = 0;
+  *margin = INFINITY;
+  if (games == 0) return;
+
+  const double points = (score.wins + 0.5 * score.draws) / games;
+  if (points <= 0 || points >= 1) {
+    *elo = points <= 0 ? -INFINITY : INFINITY;
+    return;
+  }
+  const double variance = (score.wins * (1 - points) * (1 - points) +
+                           score.draws * (0.5 - points) * (0.5 - points) +
+                           score.losses * points * points) / games;
+  const double spread = TOURNAMENT_Z * sqrt(variance / games);
+  const double low = fmax(points - spread, 1e-9), high = fmin(points + spread, 1 - 1e-9);
+  *elo = -400 * log10(1 / points - 1);
+  *margin = (-400 * log10(1 / high - 1) + 400 * log10(1 / low - 1)) / 2;
+}
+
+// Rating and 95% margin of every player of table
+void tournament_ratings(const TournamentTable *table, double *elo, double *margin) {
+  const int n = table->playerCount;
+  double gamma[TOURNAMENT_MAX_PLAYERS];
+  double games[TOURNAMENT_MAX_PLAYERS][TOURNAMENT_MAX_PLAYERS];
+  double points[TOURNAMENT_MAX_PLAYERS] = {0};
+
+  for (int i = 0; i < n; i++) {
+    gamma[i] = 1;
+    for (int j = 0; j < n; j++) {
+      const TournamentScore s = table->score[i][j];
+      games[i][j] = i == j ? 0 : s.wins + s.draws + s.losses + 1;  // Plus the virtual draw
+      points[i] += i == j ? 0 : s.wins + 0.5 * s.draws + 0.5;
+    }
+  }
+
+  // Minorisation-maximisation updates, each one raises the likelihood
+  for (int iteration = 0; iteration < TOURNAMENT_ITERATIONS; iteration++) {
+    double change = 0;
+    for (int i = 0; i < n; i++) {
+      double sum = 0;
+      for (int j = 0; j < n; j++) sum += games[i][j] / (gamma[i] + gamma[j]);
+      const double updated = sum > 0 ? points[i] / sum : 1;
+      change = fmax(change, fabs(log(updated / gamma[i])));
+      gamma[i] = updated;
+    }
+    if (change < 1e-10) break;
+  }
+
+  double mean = 0;
+  for (int i = 0; i < n; i++) {
+    elo[i] = 400 * log10(gamma[i]);
+    mean += elo[i] / n;
+  }
+  const double scale = log(10) / 400;
+  for (int i = 0; i < n; i++) {
+    elo[i] -= mean;
+    double information = 0;
+    for (int j = 0; j < n; j++) {
+      const double expected = gamma[i] / (gamma[i] + gamma[j]);
+      information += games[i][j] * expected * (1 - expected) * scale * scale;
+    }
+    margin[i] = information > 0 ? TOURNAMENT_Z / sqrt(information) : INFINITY;
+  }
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef TRAIN_KERNEL_H
+#define TRAIN_KERNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd.h"
+#include "threadpool.h"
+
+// Vectorised gradient kernel for the linear regression model. Samples are
+// stored feature-major as floats (all values of feature 0, then feature 1...)
+// and padded to TRAIN_ALIGN samples, so one instruction covers 8 samples with
+// AVX2 or 4 with NEON. Padding samples have a mask of 0 and add nothing.
+// SSE2 has no fused multiply-add and runs the scalar loop.
+//
+// The kernel sums in float over blocks of TRAIN_CHUNK samples and adds every
+// block into double, so large datasets do not lose precision.
+
+#define TRAIN_ALIGN 8          // Sample padding, a multiple of every vector width
+#define TRAIN_CHUNK 1024       // Samples summed in float before going to double
+#define TRAIN_MAX_FEATURES 32  // Largest feature count the kernel handles
+#define TRAIN_OUTPUTS(features) ((features) + 2)  // Gradients, bias gradient, squared error
+
+typedef struct {
+  int featureCount;
+  int count;     // Real samples
+  int padded;    // count rounded up to TRAIN_ALIGN
+  float *features;  // featureCount rows of padded values
+  float *labels;
+  float *mask;      // 1 for real samples, 0 for padding
+} TrainSet;
+
+// function prototypes
+bool train_set_init(TrainSet *set, int featureCount, int count);
+void train_set_sample(TrainSet *set, int index, const int8_t *features, double label);
+void train_set_free(TrainSet *set);
+void train_gradient(const TrainSet *set, const double *weights, int begin, int end,
+                    double *gradient);
+void train_gradient_scalar(const TrainSet *set, const double *weights, int begin, int end,
+                           double *gradient);
+const char *train_backend(void);
+void train_set_threads(int threads);
+void train_gradient_threaded(const TrainSet *set, const double *weights, double *gradient);
+
+// Thread count for training, 0 means one per core
+extern int trainThreads;
+
+// Values of one feature across all samples
+static inline float *train_feature(const TrainSet *set, int feature) {
+  return set->features + (size_t)feature * set->padded;
+}
+
+#ifdef ENGINE_IMPLEMENTATION
+
+// Allocate a zeroed set, returns false when out of memory
+bool train_set_init(TrainSet *set, int featureCount, int count) {
+  set->featureCount = featureCount;
+  set->count = count;
+  set->padded = (count + TRAIN_ALIGN - 1) / TRAIN_ALIGN * TRAIN_ALIGN;
+  set->features = calloc((size_t)featureCount * set->padded, sizeof(float));
+  set->labels = calloc(set->padded, sizeof(float));
+  set->mask = calloc(set->padded, sizeof(float));
+  if (featureCount > TRAIN_MAX_FEATURES || set->features == NULL || set->labels == NULL ||
+      set->mask == NULL) {
+    train_set_free(set);
+    return false;
+  }
+  return true;
+}
+
+void train_set_sample(TrainSet *set, int index, const int8_t *features, double label) {
+  for (int f = 0; f < set->featureCount; f++) train_feature(set, f)[index] = (float)features[f];
+  set->labels[index] = (float)label;
+  set->mask[index] = 1.0f;
+}
+
+void train_set_free(TrainSet *set) {
+  free(set->features);
+  free(set->labels);
+  free(set->mask);
+  set->features = NULL;
+  set->labels = NULL;
+  set->mask = NULL;
+}
+
+// Squared error gradient over samples [begin, end), both multiples of
+// TRAIN_ALIGN. gradient receives featureCount weight gradients, the bias
+// gradient and then the summed squared error (TRAIN_OUTPUTS values).
+// weights holds featureCount weights followed by the bias
+void train_gradient_scalar(const TrainSet *set, const double *weights, int begin, int end,
+                           double *gradient) {
+  const int features = set->featureCount;
+  memset(gradient, 0, sizeof(double) * TRAIN_OUTPUTS(features));
+
+  for (int start = begin; start < end; start += TRAIN_CHUNK) {
+    const int stop = start + TRAIN_CHUNK < end ? start + TRAIN_CHUNK : end;
+    float sum[TRAIN_OUTPUTS(TRAIN_MAX_FEATURES)] = {0};
+
+    for (int i = start; i < stop; i++) {
+      float predicted = (float)weights[features];  // Bias term
+      for (int f = 0; f < features; f++) predicted += (float)weights[f] * train_feature(set, f)[i];
+
+      const float error = (predicted - set->labels[i]) * set->mask[i];
+      for (int f = 0; f < features; f++) sum[f] += error * train_feature(set, f)[i];
+      sum[features] += error;  // Bias gradient
+      sum[features + 1] += error * error;
+    }
+    for (int f = 0; f < TRAIN_OUTPUTS(features); f++) gradient[f] += sum[f];
+  }
+}
+
+#if defined(SIMD_X86)
+
+// Adds up the 8 lanes in double
+__attribute__((target("avx2,fma"))) static double train_hsum_avx2(__m256 v) {
+  float lanes[8];
+  _mm256_storeu_ps(lanes, v);
+  double total = 0;
+  for (int i = 0; i < 8; i++) total += lanes[i];
+  return total;
+}
+
+__attribute__((target("avx2,fma"))) static void train_gradient_avx2(const TrainSet *set,
+                                                                   const double *weights,
+                                                                   int begin, int end,
+                                                                   double *gradient) {
+  const int features = set->featureCount;
+  __m256 w[TRAIN_MAX_FEATURES];
+  for (int f = 0; f < features; f++) w[f] = _mm256_set1_ps((float)weights[f]);
+  const __m256 bias = _mm256_set1_ps((float)weights[features]);
+  memset(gradient, 0, sizeof(double) * TRAIN_OUTPUTS(features));
+
+  for (int start = begin; start < end; start += TRAIN_CHUNK) {
+    const int stop = start + TRAIN_CHUNK < end ? start + TRAIN_CHUNK : end;
+    __m256 sum[TRAIN_OUTPUTS(TRAIN_MAX_FEATURES)];
+    for (int f = 0; f < TRAIN_OUTPUTS(features); f++) sum[f] = _mm256_setzero_ps();
+
+    for (int i = start; i < stop; i += 8) {
+      __m256 predicted = bias;
+      for (int f = 0; f < features; f++) {
+        predicted = _mm256_fmadd_ps(w[f], _mm256_loadu_ps(train_feature(set, f) + i), predicted);
+      }
+      const __m256 error = _mm256_mul_ps(_mm256_sub_ps(predicted, _mm256_loadu_ps(set->labels + i)),
+                                         _mm256_loadu_ps(set->mask + i));
+      for (int f = 0; f < features; f++) {
+        sum[f] = _mm256_fmadd_ps(error, _mm256_loadu_ps(train_feature(set, f) + i), sum[f]);
+      }
+      sum[features] = _mm256_add_ps(sum[features], error);
+      sum[features + 1] = _mm256_fmadd_ps(error, error, sum[features + 1]);
+    }
+    for (int f = 0; f < TRAIN_OUTPUTS(features); f++) gradient[f] += train_hsum_avx2(sum[f]);
+  }
+}
+
+#elif defined(SIMD_NEON)
+
+static void train_gradient_neon(const TrainSet *set, const double *weights, int begin, int end,
+                                double *gradient) {
+  const int features = set->featureCount;
+  float32x4_t w[TRAIN_MAX_FEATURES];
+  for (int f = 0; f < features; f++) w[f] = vdupq_n_f32((float)weights[f]);
+  const float32x4_t bias = vdupq_n_f32((float)weights[features]);
+  memset(gradient, 0, sizeof(double) * TRAIN_OUTPUTS(features));
+
+  for (int start = begin; start < end; start += TRAIN_CHUNK) {
+    const int stop = start + TRAIN_CHUNK < end ? start + TRAIN_CHUNK : end;
+    float32x4_t sum[TRAIN_OUTPUTS(TRAIN_MAX_FEATURES)];
+    for (int f = 0; f < TRAIN_OUTPUTS(features); f++) sum[f] = vdupq_n_f32(0);
+
+    for (int i = start; i < stop; i += 4) {
+      float32x4_t predicted = bias;
+      for (int f = 0; f < features; f++) {
+        predicted = vfmaq_f32(predicted, w[f], vld1q_f32(train_feature(set, f) + i));
+      }
+      const float32x4_t error =
+          vmulq_f32(vsubq_f32(predicted, vld1q_f32(set->labels + i)), vld1q_f32(set->mask + i));
+      for (int f = 0; f < features; f++) {
+        sum[f] = vfmaq_f32(sum[f], error, vld1q_f32(train_feature(set, f) + i));
+      }
+      sum[features] = vaddq_f32(sum[features], error);
+      sum[features + 1] = vfmaq_f32(sum[features + 1], error, error);
+    }
+    for (int f = 0; f < TRAIN_OUTPUTS(features); f++) {
+      float lanes[4];
+      vst1q_f32(lanes, sum[f]);
+      gradient[f] += (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+  }
+}
+
+#endif
+
+void train_gradient(const TrainSet *set, const double *weights, int begin, int end,
+                    double *gradient) {
+  switch (simd_level()) {
+#if defined(SIMD_X86)
+    case SIMD_AVX2:
+      train_gradient_avx2(set, weights, begin, end, gradient);
+      return;
+#elif defined(SIMD_NEON)
+    case SIMD_NEON:
+      train_gradient_neon(set, weights, begin, end, gradient);
+      return;
+#endif
+    default:
+      train_gradient_scalar(set, weights, begin, end, gradient);
+  }
+}
+
+// Name of the kernel train_gradient runs on
+const char *train_backend(void) {
+  const SimdLevel level = simd_level();
+  return simd_level_name(level == SIMD_SSE2 ? SIMD_SCALAR : level);
+}
+
+int trainThreads = 0;
+static ThreadPool trainPool;
+static bool trainPoolReady = false;
+
+// Change the number of training threads, takes effect on the next epoch
+void train_set_threads(int threads) {
+  if (trainPoolReady && threads != trainThreads) {
+    threadpool_destroy(&trainPool);
+    trainPoolReady = false;
+  }
+  trainThreads = threads;
+}
+
+typedef struct {
+  const TrainSet *set;
+  const double *weights;
+  double (*partial)[TRAIN_OUTPUTS(TRAIN_MAX_FEATURES)];  // One gradient per thread
+} TrainSplit;
+
+// Each thread takes a fixed, contiguous run of whole chunks
+static void train_task(void *arg, int thread, int threadCount) {
+  TrainSplit *split = (TrainSplit *)arg;
+  const int chunks = (split->set->padded + TRAIN_CHUNK - 1) / TRAIN_CHUNK;
+  int begin = (int)((long long)chunks * thread / threadCount) * TRAIN_CHUNK;
+  int end = (int)((long long)chunks * (thread + 1) / threadCount) * TRAIN_CHUNK;
+  if (begin > split->set->padded) begin = split->set->padded;
+  if (end > split->set->padded) end = split->set->padded;
+  train_gradient(split->set, split->weights, begin, end, split->partial[thread]);
+}
+
+// Full gradient over the set, split across the training threads. Every
+// thread fills its own accumulator and they are added up in thread order,
+// so a given thread count always gives the same result. Sets of a single
+// chunk are not worth splitting and run on the caller
+void train_gradient_threaded(const TrainSet *set, const double *weights, double *gradient) {
+  if (set->padded <= TRAIN_CHUNK || trainThreads == 1) {
+    train_gradient(set, weights, 0, set->padded, gradient);
+    return;
+  }
+  if (!trainPoolReady) {
+    threadpool_init(&trainPool, trainThreads);
+    trainPoolReady = true;
+  }
+
+  const int threads = trainPool.threadCount;
+  TrainSplit split = {set, weights, malloc(sizeof(*split.partial) * threads)};
+  if (threads == 1 || split.partial == NULL) {
+    free(split.partial);
+    train_gradient(set, weights, 0, set->padded, gradient);
+    return;
+  }
+
+  threadpool_run(&trainPool, train_task, &split);
+
+  memset(gradient, 0, sizeof(double) * TRAIN_OUTPUTS(set->featureCount));
+  for (int t = 0; t < threads; t++) {
+    for (int f = 0; f < TRAIN_OUTPUTS(set->featureCount); f++) gradient[f] += split.partial[t][f];
+  }
+  free(split.partial);
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Transposition table for mnk_negamax, shared by all search threads. Keys
+// are canonical Zobrist keys (see mnk.h), so every rotation and reflection
+// of a position finds the same entry. A slot is two words written without a
+// lock, the data and the key XORed with it: a slot torn by two threads
+// writing at once no longer matches any key and reads as empty
+#define TT_SIZE (1 << 20)  // Number of slots, must be a power of two
+
+// Kind of value stored in an entry
+#define TT_EXACT 0
+#define TT_LOWER 1  // Search failed high, real value is at least the stored one
+#define TT_UPPER 2  // Search failed low, real value is at most the stored one
+
+typedef struct {
+  int value;     // Relative to the stored node, see search_tt_store
+  int bound;     // TT_EXACT, TT_LOWER or TT_UPPER
+  int depth;     // Remaining search depth the value is valid for
+  int bestMove;  // Best move in canonical orientation, -1 if unknown
+} TTEntry;
+
+// function prototypes
+void tt_clear(void);
+bool tt_probe(uint64_t key, TTEntry *entry);
+void tt_store(uint64_t key, TTEntry entry);
+
+#ifdef ENGINE_IMPLEMENTATION
+
+typedef struct {
+  _Atomic uint64_t check;  // key ^ data
+  _Atomic uint64_t data;   // Packed TTEntry, 0 for an unused slot
+} TTSlot;
+
+static TTSlot ttTable[TT_SIZE];
+
+#define TT_USED (1ULL << 63)  // Set in the data of every stored entry
+
+static uint64_t tt_pack(TTEntry entry) {
+  return (uint32_t)entry.value | (uint64_t)entry.bound << 32 | (uint64_t)entry.depth << 34 |
+         (uint64_t)(entry.bestMove + 1) << 42 | TT_USED;
+}
+
+static TTEntry tt_unpack(uint64_t data) {
+  TTEntry entry = {(int32_t)(uint32_t)data, (int)(data >> 32) & 3, (int)(data >> 34) & 255,
+                   (int)((data >> 42) & 511) - 1};
+  return entry;
+}
+
+void tt_clear(void) {
+  for (int i = 0; i < TT_SIZE; i++) {
+    atomic_store_explicit(&ttTable[i].check, 0, memory_order_relaxed);
+    atomic_store_explicit(&ttTable[i].data, 0, memory_order_relaxed);
+  }
+}
+
+// Look up a position, false when it has not been stored
+bool tt_probe(uint64_t key, TTEntry *entry) {
+  TTSlot *slot = &ttTable[key & (TT_SIZE - 1)];
+  const uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+  const uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+  if (data == 0 || (check ^ data) != key) return false;
+  *entry = tt_unpack(data);
+  return true;
+}
+
+// Store a search result, keeping the deeper one when another position
+// already sits in the slot
+void tt_store(uint64_t key, TTEntry entry) {
+  TTSlot *slot = &ttTable[key & (TT_SIZE - 1)];
+  const uint64_t old = atomic_load_explicit(&slot->data, memory_order_relaxed);
+  const uint64_t oldCheck = atomic_load_explicit(&slot->check, memory_order_relaxed);
+  if (old != 0 && (oldCheck ^ old) != key && tt_unpack(old).depth > entry.depth) return;
+
+  const uint64_t data = tt_pack(entry);
+  atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+  atomic_store_explicit(&slot->check, key ^ data, memory_order_relaxed);
+}
+
+#endif  // ENGINE_IMPLEMENTATION
+
+#endif
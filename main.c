@@ -9,6 +9,7 @@
 // Include custom header files for game functionality
 #include "./core/game.h"
 #include "./core/gui.h"
+#include "./core/mcts.h"
 #include "./core/minimax.h"
 #include "./core/ml.h"
 #include "./core/multiplayer.h"
@@ -21,10 +22,39 @@ void unloadResources(GameResources *resources);
 void handleGameState(GameData *game, GameResources *resources, MLModel *model);
 void handleGamePlay(GameData *game, GameResources *res, MLModel *model);
 
-int main(void) {
+int main(int argc, char **argv) {
   // Weights array for machine learning implementation
   MLModel model = {0};
 
+  // --threads N sets the AI search threads and --train-threads N the model
+  // training threads, the default for both is one per core.
+  // --model linear|mlp picks the NORMAL bot's model, --playouts N sets the
+  // MONTE_CARLO bot's playouts per move,
+  // --retro FILE plays the IMPOSSIBLE bot from a table made by the retro tool,
+  // --optimizer gd|sgd|momentum|adam|normal picks how the linear model trains and
+  // --retrain ignores the cached model from the last launch
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--retrain") == 0) remove(MODEL_CACHE_FILE);
+  }
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0) search_set_threads(atoi(argv[i + 1]));
+    if (strcmp(argv[i], "--train-threads") == 0) train_set_threads(atoi(argv[i + 1]));
+    if (strcmp(argv[i], "--playouts") == 0) mctsTree.playouts = atoi(argv[i + 1]);
+    if (strcmp(argv[i], "--retro") == 0 && !retro_open(argv[i + 1], &retroTable)) {
+      printf("Cannot load the retrograde table %s\n", argv[i + 1]);
+    }
+    if (strcmp(argv[i], "--model") == 0 && !model_kind_from_name(argv[i + 1], &model.kind)) {
+      printf("Unknown model %s, use linear or mlp\n", argv[i + 1]);
+    }
+    if (strcmp(argv[i], "--optimizer") == 0) {
+      Optimizer optimizer;
+      if (optimizer_from_name(argv[i + 1], &optimizer))
+        model.config = train_config(optimizer);
+      else
+        printf("Unknown optimizer %s, use gd, sgd, momentum, adam or normal\n", argv[i + 1]);
+    }
+  }
+
 // print computer env, x64 or arm
 #if defined(_WIN64)
   printf("Environment: x64\n");
@@ -33,7 +63,11 @@ int main(void) {
 #endif
 
   // Initialize machine learning weights
-  ml_init(&model);
+  if (!ml_init(&model)) return 1;
+  ml_free(&model);  // Only the weights are needed from here on
+
+  // Solve the whole 3x3 game once so the IMPOSSIBLE bot is a table lookup
+  solver_init();
 
   // Set up window dimensions
   const int screenWidth = CELL_SIZE * GRID_SIZE;
@@ -52,6 +86,9 @@ int main(void) {
   loadResources(&resources);
   initializeGame(&gameData);
 
+  // Bot moves are computed on their own thread so the window stays responsive
+  ai_worker_start(&aiWorker);
+
   // Main game loop
   while (!WindowShouldClose()) {
     BeginDrawing();
@@ -61,6 +98,9 @@ int main(void) {
   }
 
   // Cleanup and close
+  ai_worker_stop(&aiWorker);
+  mcts_free(&mctsTree);
+  retro_close(&retroTable);
   unloadResources(&resources);
   CloseAudioDevice();
   CloseWindow();
@@ -72,11 +112,14 @@ void handleGamePlay(GameData *game, GameResources *res, MLModel *model) {
   if (game->state == ONE_PLAYER) {
     switch (game->difficulty) {
       case NORMAL:
-        humanVsML(game, res, model->weights);  // ML-based AI for normal difficulty
+        humanVsML(game, res, model);  // ML-based AI for normal difficulty
         break;
       case IMPOSSIBLE:
         mmAI(game, res);  // Minimax AI for impossible difficulty
         break;
+      case MONTE_CARLO:
+        mctsAI(game, res);  // Monte Carlo tree search AI
+        break;
       default:
         game->state = HOME;
         break;
@@ -90,10 +133,13 @@ void handleGameState(GameData *game, GameResources *res, MLModel *model) {
   // Manage audio and game states
   handleAudio(game->state, res);
 
+  // Drop any bot move still being computed once the game screen is left
+  if (game->state != ONE_PLAYER) ai_worker_cancel(&aiWorker);
+
   // Handle different game screens
   switch (game->state) {
     case HOME:
-      home_screen(&game->state, res->icon);
+      home_screen(&game->state, &game->variant, res->icon);
       break;
     case DIFFICULTY_SELECTION:
       select_difficulty(&game->state, &game->difficulty);
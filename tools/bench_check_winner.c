@@ -0,0 +1,209 @@
+// check_winner micro-benchmark: times every win check implementation over
+// all 3^9 boards and over positions from random games, and reports the
+// median ns/call of several repeats together with the fastest and slowest.
+// Every implementation is first checked against the C loop on all inputs.
+// The batch rows classify the whole set per call, times are per board.
+//
+// Usage: bench-check-winner [repeats randomPositions]
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+#define ALL_BOARDS 19683  // 3^9
+
+typedef int (*ArrayCheck)(int board[BB_CELLS]);
+typedef int (*BitboardCheck)(Bitboard board);
+typedef void (*BatchCheck)(const BBMask *x, const BBMask *o, int8_t *out, int count);
+
+// Inputs in every layout so no implementation pays for conversion
+typedef struct {
+  int (*cells)[BB_CELLS];
+  Bitboard *boards;
+  BBMask *x;      // Side masks as structure-of-arrays for the batch API
+  BBMask *o;
+  int8_t *out;    // Batch results
+  int count;
+} BoardSet;
+
+typedef struct {
+  const char *name;
+  ArrayCheck array;     // Takes the 9 int layout, or NULL
+  BitboardCheck board;  // Takes a bitboard, or NULL
+  BatchCheck batch;     // Classifies the whole set in one call, or NULL
+} Implementation;
+
+// First winning line (in check_winner order) completed by each side mask,
+// BB_NUM_LINES when there is none
+static uint8_t firstLine[1 << BB_CELLS];
+
+static void table_init(void) {
+  for (int mask = 0; mask < (1 << BB_CELLS); mask++) {
+    firstLine[mask] = BB_NUM_LINES;
+    for (int i = 0; i < BB_NUM_LINES; i++) {
+      if ((mask & BB_WIN_MASKS[i]) == BB_WIN_MASKS[i]) {
+        firstLine[mask] = i;
+        break;
+      }
+    }
+  }
+}
+
+// Two table lookups, the side whose line comes first wins like in check_winner
+static int table_check_winner(Bitboard board) {
+  const int x = firstLine[board.x];
+  const int o = firstLine[board.o];
+  if (x < o) return X;
+  if (o < x) return O;
+  if ((board.x | board.o) == BB_FULL) return TIE;
+  return EMPTY;
+}
+
+static const Implementation IMPLEMENTATIONS[] = {
+    {"C loop", check_winner_c, NULL, NULL},
+#if defined(__aarch64__)
+    {"assembly", check_winner, NULL, NULL},
+#endif
+    {"bitboard", NULL, bb_check_winner, NULL},
+    {"table", NULL, table_check_winner, NULL},
+    {"batch C", NULL, NULL, bb_check_winner_batch_scalar},
+    {"batch SIMD", NULL, NULL, bb_check_winner_batch},
+};
+#define NUM_IMPLEMENTATIONS (int)(sizeof(IMPLEMENTATIONS) / sizeof(IMPLEMENTATIONS[0]))
+
+static void set_alloc(BoardSet *set, int count) {
+  set->cells = malloc(sizeof(*set->cells) * count);
+  set->boards = malloc(sizeof(*set->boards) * count);
+  set->x = malloc(sizeof(*set->x) * count);
+  set->o = malloc(sizeof(*set->o) * count);
+  set->out = malloc(sizeof(*set->out) * count);
+  set->count = count;
+  if (set->cells == NULL || set->boards == NULL || set->x == NULL || set->o == NULL ||
+      set->out == NULL) {
+    printf("Out of memory\n");
+    exit(1);
+  }
+}
+
+// Every base 3 board, including unreachable ones
+static void all_boards(BoardSet *set) {
+  set_alloc(set, ALL_BOARDS);
+  for (int index = 0; index < ALL_BOARDS; index++) {
+    int rest = index;
+    for (int cell = 0; cell < BB_CELLS; cell++, rest /= 3) {
+      static const int VALUES[3] = {EMPTY, X, O};
+      set->cells[index][cell] = VALUES[rest % 3];
+    }
+    set->boards[index] = bb_from_array(set->cells[index]);
+    set->x[index] = set->boards[index].x;
+    set->o[index] = set->boards[index].o;
+  }
+}
+
+// Positions met in real play: random games cut off at a random move
+static void random_positions(BoardSet *set, int count) {
+  set_alloc(set, count);
+  for (int n = 0; n < count; n++) {
+    Bitboard board = {0, 0};
+    int stop = rand() % (BB_CELLS + 1);
+    int player = X;
+    for (int ply = 0; ply < stop && bb_check_winner(board) == EMPTY; ply++) {
+      BBMask moves = bb_empty(board);
+      int skip = rand() % bb_popcount(moves);
+      while (skip--) bb_pop_lsb(&moves);
+      bb_make_move(&board, bb_pop_lsb(&moves), player);
+      player = -player;
+    }
+    set->boards[n] = board;
+    set->x[n] = board.x;
+    set->o[n] = board.o;
+    bb_to_array(board, set->cells[n]);
+  }
+}
+
+// One pass over the set, the checksum keeps the calls from being optimised out
+static long long run_once(const Implementation *impl, const BoardSet *set) {
+  long long checksum = 0;
+  if (impl->batch != NULL) {
+    impl->batch(set->x, set->o, set->out, set->count);
+    for (int i = 0; i < set->count; i++) checksum += set->out[i];
+  } else if (impl->array != NULL) {
+    for (int i = 0; i < set->count; i++) checksum += impl->array(set->cells[i]);
+  } else {
+    for (int i = 0; i < set->count; i++) checksum += impl->board(set->boards[i]);
+  }
+  return checksum;
+}
+
+static bool verify(const Implementation *impl, const BoardSet *set) {
+  if (impl->batch != NULL) impl->batch(set->x, set->o, set->out, set->count);
+  for (int i = 0; i < set->count; i++) {
+    int expected = check_winner_c(set->cells[i]);
+    int got = impl->batch != NULL   ? set->out[i]
+              : impl->array != NULL ? impl->array(set->cells[i])
+                                    : impl->board(set->boards[i]);
+    if (got != expected) return false;
+  }
+  return true;
+}
+
+// Sort the per-repeat timings and print median, min and max ns/call
+static void bench_set(const char *title, const BoardSet *set, int repeats) {
+  // Enough passes per repeat for each timing to cover a few milliseconds
+  const int passes = 1 + 2000000 / set->count;
+  volatile long long sink = 0;
+
+  printf("\n%s, %d boards x %d passes, %d repeats\n", title, set->count, passes, repeats);
+  printf("%-10s %10s %10s %10s %14s %s\n", "impl", "median ns", "min ns", "max ns", "calls/sec",
+         "result");
+
+  for (int i = 0; i < NUM_IMPLEMENTATIONS; i++) {
+    const Implementation *impl = &IMPLEMENTATIONS[i];
+    const bool exact = verify(impl, set);
+    double perCall[BENCH_MAX_REPEATS];
+
+    sink += run_once(impl, set);  // Warm up caches and branch predictors
+    for (int r = 0; r < repeats; r++) {
+      double start = bench_now_ns();
+      for (int p = 0; p < passes; p++) sink += run_once(impl, set);
+      perCall[r] = (bench_now_ns() - start) / ((double)passes * set->count);
+    }
+    bench_sort(perCall, repeats);
+
+    const double median = perCall[repeats / 2];
+    printf("%-10s %10.2f %10.2f %10.2f %14.0f %s\n", impl->name, median, perCall[0],
+           perCall[repeats - 1], 1e9 / median, exact ? "exact" : "MISMATCH");
+  }
+  (void)sink;
+}
+
+int main(int argc, char **argv) {
+  int repeats = 11;
+  int randomCount = 100000;
+
+  if (argc >= 2) repeats = atoi(argv[1]);
+  if (argc >= 3) randomCount = atoi(argv[2]);
+  if (repeats < 1 || repeats > BENCH_MAX_REPEATS || randomCount < 1) {
+    printf("Usage: %s [repeats (1-%d) randomPositions]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+#if defined(__aarch64__)
+  printf("Environment: ARM\n");
+#else
+  printf("Environment: x64\n");
+#endif
+  printf("Batch backend: %s\n", bb_batch_backend());
+
+  srand(1);  // Same random positions every run
+  table_init();
+
+  BoardSet every, games;
+  all_boards(&every);
+  random_positions(&games, randomCount);
+
+  bench_set("All 3^9 boards", &every, repeats);
+  bench_set("Random game positions", &games, repeats);
+  return 0;
+}
@@ -0,0 +1,34 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdlib.h>
+#include <time.h>
+
+// Timing helpers shared by the benchmark tools. Each timing is repeated and
+// the median reported, which a few slow runs (another process, a cold
+// cache) cannot move the way they move the mean
+#define BENCH_MAX_REPEATS 101  // Most repeats a tool keeps samples for
+
+static inline double bench_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static inline int bench_compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Sort samples in place, fastest first
+static inline void bench_sort(double *samples, int count) {
+  qsort(samples, count, sizeof(double), bench_compare_double);
+}
+
+// Sort samples in place and return the middle one
+static inline double bench_median(double *samples, int count) {
+  bench_sort(samples, count);
+  return samples[count / 2];
+}
+
+#endif
@@ -0,0 +1,167 @@
+// Dataset loading throughput report: loads the UCI dataset, then a synthetic
+// file of random rows in the same format, with the original fgets/strtok
+// loop and with load_data on 1, 2, 4... threads. Prints rows/sec, MB/s and
+// the peak resident memory of each load (Linux only, the peak is reset
+// before every load through /proc/self/clear_refs).
+//
+// Usage: load-bench [rows repeats maxThreads]   (run from the repository root)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+#define SYNTHETIC_FILE "./build/load-bench.data"
+
+// The loader as it was before load_data mapped the file, kept as the baseline
+static bool load_original(const char *filename, MLModel *model) {
+  FILE *file = fopen(filename, "r");
+  if (!file) return false;
+
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    if (model->sampleCount == model->capacity &&
+        !ml_reserve(model, model->capacity ? model->capacity * 2 : 1024)) {
+      fclose(file);
+      return false;
+    }
+    char *token = strtok(line, ",");
+    int8_t *features = model->features + (size_t)model->sampleCount * MAX_FEATURES;
+    int feature_index = 0;
+    while (token && feature_index < MAX_FEATURES) {
+      features[feature_index++] = token[0] == 'x' ? 1 : token[0] == 'o' ? -1 : 0;
+      token = strtok(NULL, ",");
+    }
+    model->labels[model->sampleCount] = (strcmp(token, "positive\n") == 0) ? 1 : 0;
+    model->sampleCount++;
+  }
+  fclose(file);
+  return true;
+}
+
+// Forget the peak so far, so the next reading covers one load only
+static void peak_memory_reset(void) {
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  if (file == NULL) return;
+  fputs("5", file);
+  fclose(file);
+}
+
+// Peak resident memory in MB since the last reset, -1 when unknown
+static double peak_memory_mb(void) {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (file == NULL) return -1;
+  char line[256];
+  double peak = -1;
+  while (fgets(line, sizeof(line), file)) {
+    long kb;
+    if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) peak = kb / 1024.0;
+  }
+  fclose(file);
+  return peak;
+}
+
+// rows random rows: 9 cells of x, o or b and a label
+static bool write_synthetic(const char *filename, long long rows) {
+  FILE *file = fopen(filename, "w");
+  if (file == NULL) return false;
+  static const char CELLS[] = "xob";
+  char line[32];
+  for (long long r = 0; r < rows; r++) {
+    char *p = line;
+    for (int i = 0; i < MAX_FEATURES; i++) {
+      *p++ = CELLS[rand() % 3];
+      *p++ = ',';
+    }
+    strcpy(p, rand() % 2 ? "positive\n" : "negative\n");
+    fputs(line, file);
+  }
+  return fclose(file) == 0;
+}
+
+// Load filename repeats times with threads threads (0 for the original
+// loop) and print the median time and the highest peak memory
+static void bench_load(const char *filename, double megabytes, int threads, int repeats,
+                       double baseRate, double *rate) {
+  double seconds[BENCH_MAX_REPEATS];
+  double peak = -1;
+  int rows = 0;
+  bool ok = true;
+
+  for (int r = 0; r < repeats && ok; r++) {
+    MLModel model = {0};
+    peak_memory_reset();
+    const double start = search_now_ms();
+    if (threads == 0) {
+      ok = load_original(filename, &model);
+    } else {
+      DatasetError error;
+      train_set_threads(threads);
+      ok = load_data(filename, &model, &error);
+      if (!ok) print_dataset_error(filename, &error);
+    }
+    seconds[r] = (search_now_ms() - start) / 1000.0;
+    const double used = peak_memory_mb();
+    if (used > peak) peak = used;
+    rows = model.sampleCount;
+    ml_free(&model);
+  }
+  if (!ok) return;
+
+  const double median = bench_median(seconds, repeats);
+  *rate = rows / median;
+  if (threads == 0) {
+    printf("%-10s", "original");
+  } else {
+    printf("%-10d", threads);
+  }
+  printf(" %14.0f %10.1f %12.2f %9.2fx %12.1f\n", *rate, megabytes / median, median * 1000.0,
+         baseRate > 0 ? *rate / baseRate : 1.0, peak);
+}
+
+static void bench_file(const char *filename, int repeats, int maxThreads) {
+  MappedFile file;
+  if (!mapped_file_open(filename, &file)) {
+    printf("Error opening '%s'.\n", filename);
+    return;
+  }
+  const double megabytes = file.size / (1024.0 * 1024.0);
+  mapped_file_close(&file);
+
+  printf("\n%s, %.1f MB, %d cores\n", filename, megabytes, threadpool_cpu_count());
+  printf("%-10s %14s %10s %12s %10s %12s\n", "threads", "rows/sec", "MB/s", "ms/load", "speedup",
+         "peak MB");
+
+  double baseRate = 0;
+  double rate = 0;
+  bench_load(filename, megabytes, 0, repeats, 0, &baseRate);
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    bench_load(filename, megabytes, threads, repeats, baseRate, &rate);
+  }
+}
+
+int main(int argc, char **argv) {
+  long long rows = 10000000;
+  int repeats = 3;
+  int maxThreads = threadpool_cpu_count();
+
+  if (argc >= 2) rows = atoll(argv[1]);
+  if (argc >= 3) repeats = atoi(argv[2]);
+  if (argc >= 4) maxThreads = atoi(argv[3]);
+  if (rows < 1 || repeats < 1 || repeats > BENCH_MAX_REPEATS || maxThreads < 1) {
+    printf("Usage: %s [rows repeats (1-%d) maxThreads]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+  bench_file(DATASET_FILE, repeats, maxThreads);
+
+  srand(1);  // Same file every run
+  if (!write_synthetic(SYNTHETIC_FILE, rows)) {
+    printf("Error writing '%s'.\n", SYNTHETIC_FILE);
+    return 1;
+  }
+  bench_file(SYNTHETIC_FILE, repeats, maxThreads);
+  remove(SYNTHETIC_FILE);
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Monte Carlo tree search report: playouts/sec and speed-up of fixed budget
+// searches on 1, 2, 4... threads, the visits tree reuse carries over
+// between the moves of a game, and the results of the 3x3 engine against
+// perfect play (a correct MCTS never loses there).
+//
+// Usage: mcts-bench [rows cols k playouts maxThreads games]
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/engine.h"
+
+// Opening stones played before each timed search, -1 terminated, X first
+static const int OPENINGS[][8] = {
+    {24, -1},
+    {24, 25, 17, -1},
+    {24, 32, 16, 25, -1},
+};
+#define NUM_OPENINGS (int)(sizeof(OPENINGS) / sizeof(OPENINGS[0]))
+
+static void play_opening(MnkVariant variant, int opening, MnkBoard *board, int *player) {
+  mnk_clear(board);
+  *player = X;
+  for (int j = 0; OPENINGS[opening][j] >= 0; j++) {
+    // Keep the openings on the board for small variants
+    mnk_make_move(variant, board, OPENINGS[opening][j] % mnk_cells(variant), *player);
+    *player = -*player;
+  }
+}
+
+// A perfect move, picked at random among the equally good ones
+static int perfect_move(Bitboard board, int player) {
+  int best = -SEARCH_INF, ties = 0, move = -1;
+  BBMask moves = bb_empty(board);
+  while (moves) {
+    const int cell = bb_pop_lsb(&moves);
+    bb_make_move(&board, cell, player);
+    const int score = -solver_score(board);
+    bb_unmake_move(&board, cell);
+    if (score > best) {
+      best = score;
+      move = cell;
+      ties = 1;
+    } else if (score == best && rand() % ++ties == 0) {
+      move = cell;
+    }
+  }
+  return move;
+}
+
+// MCTS against the perfect-play table on 3x3, MCTS taking X in even games
+static void bench_classic(int playouts, int games) {
+  const MnkVariant classic = {3, 3, 3};
+  MctsTree tree = {0};
+  int results[3] = {0, 0, 0};  // MCTS wins, draws, losses
+  solver_init();
+  srand(1);
+
+  for (int game = 0; game < games; game++) {
+    const int mctsSide = game % 2 == 0 ? X : O;
+    MnkBoard board;
+    mnk_clear(&board);
+    int player = X, winner = EMPTY, move = -1;
+    while (winner == EMPTY) {
+      if (player == mctsSide) {
+        move = mcts_search(&tree, classic, &board, player, playouts, NULL).bestMove;
+      } else {
+        move = perfect_move(mnk_to_bitboard(&board), player);
+      }
+      mnk_make_move(classic, &board, move, player);
+      winner = mnk_check_winner(classic, &board, move);
+      player = -player;
+    }
+    results[winner == TIE ? 1 : winner == mctsSide ? 0 : 2]++;
+  }
+  mcts_free(&tree);
+  printf("\n3x3 against perfect play, %d playouts per move, %d games\n", playouts, games);
+  printf("MCTS wins %d, draws %d, losses %d\n", results[0], results[1], results[2]);
+}
+
+// One game of the engine against itself with a shared tree, printing the
+// visits each search started from
+static void bench_reuse(MnkVariant variant, int playouts) {
+  MctsTree tree = {0};
+  MnkBoard board;
+  mnk_clear(&board);
+  int player = X, winner = EMPTY;
+  long long reused = 0, total = 0;
+  printf("\nTree reuse, one self-play game on %s\n", mnk_variant_name(variant));
+  printf("%6s %8s %14s %10s\n", "move", "cell", "reused visits", "depth");
+  while (winner == EMPTY) {
+    const SearchResult result = mcts_search(&tree, variant, &board, player, playouts, NULL);
+    if (board.moves < 12) {
+      printf("%6d %8d %14d %10d\n", board.moves + 1, result.bestMove, tree.reusedVisits,
+             result.depth);
+    }
+    reused += tree.reusedVisits;
+    total += tree.reusedVisits + playouts;
+    mnk_make_move(variant, &board, result.bestMove, player);
+    winner = mnk_check_winner(variant, &board, result.bestMove);
+    player = -player;
+  }
+  printf("%d moves, %.1f%% of the visits came from earlier searches\n", board.moves,
+         100.0 * reused / total);
+  mcts_free(&tree);
+}
+
+int main(int argc, char **argv) {
+  MnkVariant variant = {7, 7, 4};
+  int playouts = MCTS_PLAYOUTS;
+  int maxThreads = threadpool_cpu_count();
+  int games = 100;
+
+  if (argc >= 4) {
+    variant.rows = atoi(argv[1]);
+    variant.cols = atoi(argv[2]);
+    variant.k = atoi(argv[3]);
+  }
+  if (argc >= 5) playouts = atoi(argv[4]);
+  if (argc >= 6) maxThreads = atoi(argv[5]);
+  if (argc >= 7) games = atoi(argv[6]);
+  if (!mnk_variant_valid(variant) || playouts < 1 || maxThreads < 1 || games < 0) {
+    printf("Usage: %s [rows cols k playouts maxThreads games]\n", argv[0]);
+    return 1;
+  }
+
+  printf("Board %s, %d playouts per search, %d cores\n", mnk_variant_name(variant), playouts,
+         threadpool_cpu_count());
+  printf("%8s %10s %14s %14s %8s %s\n", "threads", "time ms", "playouts", "playouts/sec",
+         "speedup", "moves");
+
+  double baseRate = 0;
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    search_set_threads(threads);
+    unsigned long long int total = 0;
+    int moves[NUM_OPENINGS];
+    const double start = search_now_ms();
+
+    for (int i = 0; i < NUM_OPENINGS; i++) {
+      MctsTree tree = {0};  // Fresh tree, nothing reused
+      MnkBoard board;
+      int player;
+      play_opening(variant, i, &board, &player);
+      const SearchResult result = mcts_search(&tree, variant, &board, player, playouts, NULL);
+      total += result.nodes;
+      moves[i] = result.bestMove;
+      mcts_free(&tree);
+    }
+
+    const double elapsed = search_now_ms() - start;
+    const double rate = total / (elapsed / 1000.0);
+    if (threads == 1) baseRate = rate;
+    printf("%8d %10.1f %14llu %14.0f %7.2fx", threads, elapsed, total, rate, rate / baseRate);
+    for (int i = 0; i < NUM_OPENINGS; i++) printf(" %d", moves[i]);
+    printf("\n");
+  }
+
+  search_set_threads(maxThreads);
+  bench_reuse(variant, playouts);
+  if (games > 0) bench_classic(playouts / 10 > 0 ? playouts / 10 : 1, games);
+  return 0;
+}
@@ -0,0 +1,185 @@
+// ML move scoring benchmark: trains the linear model (closed form) and
+// scores every move of positions from random games, first one board at a
+// time as get_best_ai_move used to (make the move, predict, undo) and then
+// with ml_score_moves, which values all moves of a position in one pass.
+// Then every resulting board is valued in bulk with the scalar and SIMD
+// ml_value_batch. Prints moves or boards per second and checks that every
+// method agrees with predict_bitboard.
+//
+// Usage: ml-bench [positions repeats]   (run from the repository root)
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+
+typedef void (*BatchFn)(const BBMask *x, const BBMask *o, const double *weights, float *out,
+                        int count);
+
+static double weights[MAX_FEATURES + 1];
+static Bitboard *positions;  // O to move, game not over
+static int positionCount;
+static int8_t *predicted;     // Thresholded score of every move, in position and cell order
+static long long moveCount;
+static volatile double sink;  // Keeps the timed loops from being optimised away
+
+// Positions with O to move from random games
+static void make_positions(int count) {
+  positions = malloc(sizeof(Bitboard) * count);
+  positionCount = 0;
+  while (positionCount < count) {
+    Bitboard board = {0, 0};
+    int player = X;
+    while (bb_check_winner(board) == EMPTY && positionCount < count) {
+      if (player == O) positions[positionCount++] = board;
+      BBMask moves = bb_empty(board);
+      int skip = rand() % __builtin_popcount(moves);
+      while (skip--) bb_pop_lsb(&moves);
+      bb_make_move(&board, bb_pop_lsb(&moves), player);
+      player = -player;
+    }
+  }
+}
+
+// Make, predict, undo for every empty cell
+static long long score_original(int8_t *out) {
+  long long n = 0;
+  for (int p = 0; p < positionCount; p++) {
+    Bitboard board = positions[p];
+    BBMask moves = bb_empty(board);
+    while (moves) {
+      const int cell = bb_pop_lsb(&moves);
+      bb_make_move(&board, cell, O);
+      out[n++] = (int8_t)predict_bitboard(board, weights);
+      bb_unmake_move(&board, cell);
+    }
+  }
+  return n;
+}
+
+// All moves of a position from one value
+static long long score_batched(int8_t *out) {
+  long long n = 0;
+  double values[BB_CELLS];
+  for (int p = 0; p < positionCount; p++) {
+    BBMask moves = ml_score_moves(positions[p], O, weights, values);
+    while (moves) out[n++] = values[bb_pop_lsb(&moves)] >= 0.5;
+  }
+  return n;
+}
+
+// Median seconds of repeats runs of score, and its mismatches with predicted
+static double time_scoring(long long (*score)(int8_t *), int repeats, long long *mismatches) {
+  int8_t *out = malloc(moveCount);
+  double seconds[BENCH_MAX_REPEATS];
+  for (int r = 0; r < repeats; r++) {
+    const double start = search_now_ms();
+    score(out);
+    seconds[r] = (search_now_ms() - start) / 1000.0;
+  }
+  *mismatches = 0;
+  for (long long i = 0; i < moveCount; i++) *mismatches += out[i] != predicted[i];
+  free(out);
+  return bench_median(seconds, repeats);
+}
+
+// Every board after a move, as the structure-of-arrays masks the batch takes
+static void bench_bulk(int repeats) {
+  BBMask *x = malloc(sizeof(BBMask) * moveCount);
+  BBMask *o = malloc(sizeof(BBMask) * moveCount);
+  float *out = malloc(sizeof(float) * moveCount);
+  double *exact = malloc(sizeof(double) * moveCount);
+  long long n = 0;
+  for (int p = 0; p < positionCount; p++) {
+    BBMask moves = bb_empty(positions[p]);
+    while (moves) {
+      Bitboard board = positions[p];
+      bb_make_move(&board, bb_pop_lsb(&moves), O);
+      x[n] = board.x;
+      o[n] = board.o;
+      exact[n++] = ml_board_value(board, weights);
+    }
+  }
+
+  printf("\n%lld boards, bulk backend: %s\n", moveCount, ml_batch_backend());
+  printf("%-14s %14s %12s %10s %12s\n", "bulk", "boards/sec", "ms/run", "speedup", "max diff");
+
+  static const char *NAMES[] = {"batch C", "batch SIMD"};
+  const BatchFn BATCHES[] = {ml_value_batch_scalar, ml_value_batch};
+  double baseRate = 0;
+  for (int b = 0; b < 2; b++) {
+    double seconds[BENCH_MAX_REPEATS];
+    for (int r = 0; r < repeats; r++) {
+      const double start = search_now_ms();
+      BATCHES[b](x, o, weights, out, (int)moveCount);
+      seconds[r] = (search_now_ms() - start) / 1000.0;
+      sink = out[r % moveCount];
+    }
+    const double median = bench_median(seconds, repeats);
+
+    double diff = 0;
+    for (long long i = 0; i < moveCount; i++) diff = fmax(diff, fabs(out[i] - exact[i]));
+    const double rate = moveCount / median;
+    if (b == 0) baseRate = rate;
+    printf("%-14s %14.0f %12.3f %9.2fx %12.2e\n", NAMES[b], rate, median * 1000.0,
+           rate / baseRate, diff);
+  }
+  free(x);
+  free(o);
+  free(out);
+  free(exact);
+}
+
+int main(int argc, char **argv) {
+  int count = 200000;
+  int repeats = 11;
+  if (argc >= 2) count = atoi(argv[1]);
+  if (argc >= 3) repeats = atoi(argv[2]);
+  if (count < 1 || repeats < 1 || repeats > BENCH_MAX_REPEATS) {
+    printf("Usage: %s [positions repeats (1-%d)]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+  MLModel model = {0};
+  DatasetError error;
+  if (!load_data(DATASET_FILE, &model, &error)) {
+    print_dataset_error(DATASET_FILE, &error);
+    return 1;
+  }
+  srand(1);  // Same split and positions every run
+  model.trainSplit = 0.8;
+  shuffle_data(&model);
+  split_data(&model);
+  model.config = train_config(OPTIMIZER_NORMAL);
+  train_linear_regression(&model);
+  memcpy(weights, model.weights, sizeof(weights));
+  ml_free(&model);
+
+  make_positions(count);
+  for (int p = 0; p < positionCount; p++) moveCount += __builtin_popcount(bb_empty(positions[p]));
+  predicted = malloc(moveCount);
+  score_original(predicted);
+
+  printf("%d positions, %lld moves, %d repeats\n", positionCount, moveCount, repeats);
+  printf("%-14s %14s %12s %10s %12s\n", "scoring", "moves/sec", "ms/run", "speedup",
+         "mismatches");
+
+  static const char *NAMES[] = {"make/predict", "score_moves"};
+  long long (*const SCORERS[])(int8_t *) = {score_original, score_batched};
+  double baseRate = 0;
+  for (int s = 0; s < 2; s++) {
+    long long mismatches;
+    const double seconds = time_scoring(SCORERS[s], repeats, &mismatches);
+    const double rate = moveCount / seconds;
+    if (s == 0) baseRate = rate;
+    printf("%-14s %14.0f %12.3f %9.2fx %12lld\n", NAMES[s], rate, seconds * 1000.0,
+           rate / baseRate, mismatches);
+  }
+
+  bench_bulk(repeats);
+  free(positions);
+  free(predicted);
+  return 0;
+}
@@ -0,0 +1,286 @@
+// Linear model against the MLP: trains both on the same split of the UCI
+// dataset, prints test accuracy and F1 of the linear model, the float MLP
+// and its int8 copy, then times picking a move (scoring every candidate) on
+// positions from random games, reporting ns per move and how often the int8
+// network picks the same move as the float one. Last checks that both models
+// rank the moves of a few fixed m,n,k positions the same way through
+// predict_mnk_cell, the NORMAL bot's scorer on larger boards.
+//
+// Usage: mlp-bench [positions repeats]   (run from the repository root)
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+
+#define RANK_TIE 0.01    // Move values this close count as tied
+#define RANK_AGREE 0.9    // Share of untied move pairs both models must order alike
+
+// 5x5 k=4 positions with O to move, rows top to bottom
+static const char *RANK_POSITIONS[] = {
+    ".....\n..X..\n..X..\n..O..\n.....",
+    ".....\n.XXO.\n.OX..\n.....\n.....",
+    ".....\n.OX..\n.XX..\n..O..\n.....",
+    ".....\n..O..\n.XXX.\n..O..\n.....",
+    ".....\n.X.O.\n..X..\n.O...\n.....",
+};
+
+static MLModel model;
+static Bitboard *positions;  // O to move, game not over
+static int positionCount;
+static int8_t *picked;       // Move chosen for every position by the last run
+
+static void to_features(Bitboard board, int8_t features[BB_CELLS]) {
+  for (int i = 0; i < BB_CELLS; i++) features[i] = (int8_t)bb_cell(board, i);
+}
+
+// Accuracy and F1 on the test rows of predictor's classes
+static void print_metrics(const char *name, int (*predictor)(int index)) {
+  int tp = 0, fp = 0, fn = 0, correct = 0;
+  for (int i = model.trainSize; i < model.sampleCount; i++) {
+    const int predicted = predictor(i);
+    const int actual = model.labels[i];
+    correct += predicted == actual;
+    tp += predicted && actual;
+    fp += predicted && !actual;
+    fn += !predicted && actual;
+  }
+  const double precision = (double)tp / (tp + fp + 1e-10);
+  const double recall = (double)tp / (tp + fn + 1e-10);
+  printf("%-12s %10.4f %10.4f\n", name, (double)correct / model.testSize,
+         2 * precision * recall / (precision + recall + 1e-10));
+}
+
+static int predict_linear(int index) {
+  return (int)predict(ml_sample(&model, index), model.weights);
+}
+
+static int predict_float(int index) { return mlp_logit(&model.mlp, ml_sample(&model, index)) >= 0; }
+
+static int predict_int8(int index) {
+  Bitboard board = {0, 0};
+  const int8_t *features = ml_sample(&model, index);
+  for (int i = 0; i < BB_CELLS; i++) {
+    if (features[i]) bb_make_move(&board, i, features[i] > 0 ? X : O);
+  }
+  return mlp_int8_logit(&model.mlpInt8, board) >= 0;
+}
+
+// Positions with O to move from random games
+static void make_positions(int count) {
+  positions = malloc(sizeof(Bitboard) * count);
+  picked = malloc(count);
+  positionCount = 0;
+  while (positionCount < count) {
+    Bitboard board = {0, 0};
+    int player = X;
+    while (bb_check_winner(board) == EMPTY && positionCount < count) {
+      if (player == O) positions[positionCount++] = board;
+      BBMask moves = bb_empty(board);
+      int skip = rand() % bb_popcount(moves);
+      while (skip--) bb_pop_lsb(&moves);
+      bb_make_move(&board, bb_pop_lsb(&moves), player);
+      player = -player;
+    }
+  }
+}
+
+// Best move by the linear model's thresholded value, no noise
+static void pick_linear(void) {
+  double values[BB_CELLS];
+  for (int p = 0; p < positionCount; p++) {
+    BBMask moves = ml_score_moves(positions[p], O, model.weights, values);
+    int best = -1;
+    double bestScore = -DBL_MAX;
+    while (moves) {
+      const int cell = bb_pop_lsb(&moves);
+      const double score = values[cell] >= 0.5;
+      if (score > bestScore) {
+        bestScore = score;
+        best = cell;
+      }
+    }
+    picked[p] = (int8_t)best;
+  }
+}
+
+// The same reply search as mlp_int8_score_moves, on the float network
+static void pick_float(void) {
+  for (int p = 0; p < positionCount; p++) {
+    Bitboard board = positions[p];
+    BBMask moves = bb_empty(board);
+    int best = -1;
+    float bestScore = -FLT_MAX;
+    while (moves) {
+      const int cell = bb_pop_lsb(&moves);
+      bb_make_move(&board, cell, O);
+      BBMask replies = bb_empty(board);
+      int8_t features[BB_CELLS];
+      float worst = FLT_MAX;
+      if (!replies) {
+        to_features(board, features);
+        worst = -mlp_logit(&model.mlp, features);
+      }
+      while (replies) {
+        const int reply = bb_pop_lsb(&replies);
+        bb_make_move(&board, reply, X);
+        to_features(board, features);
+        const float score = -mlp_logit(&model.mlp, features);
+        if (score < worst) worst = score;
+        bb_unmake_move(&board, reply);
+      }
+      bb_unmake_move(&board, cell);
+      if (worst > bestScore) {
+        bestScore = worst;
+        best = cell;
+      }
+    }
+    picked[p] = (int8_t)best;
+  }
+}
+
+static void pick_int8(void) {
+  int32_t scores[BB_CELLS];
+  for (int p = 0; p < positionCount; p++) {
+    BBMask moves = mlp_int8_score_moves(&model.mlpInt8, positions[p], O, scores);
+    int best = -1;
+    int32_t bestScore = INT32_MIN;
+    while (moves) {
+      const int cell = bb_pop_lsb(&moves);
+      if (best == -1 || scores[cell] > bestScore) {
+        bestScore = scores[cell];
+        best = cell;
+      }
+    }
+    picked[p] = (int8_t)best;
+  }
+}
+
+// predict_mnk_cell of every O move on board with the model of kind
+static void value_mnk_moves(MnkVariant variant, MnkBoard *board, ModelKind kind,
+                            const int *moves, int count, double *values) {
+  model.kind = kind;
+  for (int i = 0; i < count; i++) {
+    mnk_make_move(variant, board, moves[i], O);
+    values[i] = predict_mnk_cell(variant, board, moves[i], &model);
+    mnk_unmake_move(variant, board, moves[i]);
+  }
+}
+
+// Whether the linear model and the network order the moves of every
+// RANK_POSITIONS board alike, counting the pairs neither model ties
+static bool check_mnk_ranking(void) {
+  const MnkVariant variant = {5, 5, 4};
+  const int positions = sizeof(RANK_POSITIONS) / sizeof(RANK_POSITIONS[0]);
+  bool allAgree = true;
+
+  printf("\n%s positions, move pairs ordered alike by both models\n", mnk_variant_name(variant));
+  printf("%8s %12s %10s %8s\n", "position", "pairs", "agree", "result");
+  for (int p = 0; p < positions; p++) {
+    MnkBoard board;
+    mnk_clear(&board);
+    int cell = 0;
+    for (const char *c = RANK_POSITIONS[p]; *c; c++) {
+      if (*c == '\n') continue;
+      if (*c != '.') mnk_make_move(variant, &board, cell, *c == 'X' ? X : O);
+      cell++;
+    }
+
+    int moves[MNK_MAX_CELLS];
+    double linear[MNK_MAX_CELLS], network[MNK_MAX_CELLS];
+    const int count = mnk_candidate_moves(variant, &board, moves);
+    value_mnk_moves(variant, &board, MODEL_LINEAR, moves, count, linear);
+    value_mnk_moves(variant, &board, MODEL_MLP, moves, count, network);
+
+    int pairs = 0, agree = 0;
+    for (int i = 0; i < count; i++) {
+      for (int j = i + 1; j < count; j++) {
+        const double a = linear[i] - linear[j], b = network[i] - network[j];
+        if (fabs(a) < RANK_TIE || fabs(b) < RANK_TIE) continue;
+        pairs++;
+        agree += (a > 0) == (b > 0);
+      }
+    }
+    const bool ok = pairs > 0 && agree >= RANK_AGREE * pairs;
+    allAgree &= ok;
+    printf("%8d %12d %9.1f%% %8s\n", p + 1, pairs, pairs ? 100.0 * agree / pairs : 0.0,
+           ok ? "same" : "DIFFERENT");
+  }
+  return allAgree;
+}
+
+// Median ns per position of repeats runs of pick
+static double time_picking(void (*pick)(void), int repeats) {
+  double seconds[BENCH_MAX_REPEATS];
+  for (int r = 0; r < repeats; r++) {
+    const double start = search_now_ms();
+    pick();
+    seconds[r] = (search_now_ms() - start) / 1000.0;
+  }
+  return bench_median(seconds, repeats) * 1e9 / positionCount;
+}
+
+int main(int argc, char **argv) {
+  int count = 100000;
+  int repeats = 5;
+  if (argc >= 2) count = atoi(argv[1]);
+  if (argc >= 3) repeats = atoi(argv[2]);
+  if (count < 1 || repeats < 1 || repeats > BENCH_MAX_REPEATS) {
+    printf("Usage: %s [positions repeats (1-%d)]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+  DatasetError error;
+  if (!load_data(DATASET_FILE, &model, &error)) {
+    print_dataset_error(DATASET_FILE, &error);
+    return 1;
+  }
+  srand(1);  // Same split, initialisation and positions every run
+  model.trainSplit = 0.8;
+  shuffle_data(&model);
+  split_data(&model);
+
+  model.config = train_config(OPTIMIZER_ADAM);
+  double start = search_now_ms();
+  train_linear_regression(&model);
+  const double linearMs = search_now_ms() - start;
+
+  start = search_now_ms();
+  train_mlp(&model);
+  const double mlpMs = search_now_ms() - start;
+
+  printf("%d training and %d test samples\n", model.trainSize, model.testSize);
+  printf("linear (adam) trained in %.2f ms, MLP (%d hidden) in %.2f ms over %d epochs\n\n",
+         linearMs, MLP_HIDDEN, mlpMs, model.epochsRun);
+  printf("%-12s %10s %10s\n", "model", "accuracy", "test F1");
+  print_metrics("linear", predict_linear);
+  print_metrics("mlp float", predict_float);
+  print_metrics("mlp int8", predict_int8);
+
+  make_positions(count);
+  int8_t *floatPicks = malloc(positionCount);
+  printf("\n%d positions, %d repeats\n", positionCount, repeats);
+  printf("%-12s %12s %14s\n", "model", "ns/move", "same as float");
+
+  const double linearNs = time_picking(pick_linear, repeats);
+  printf("%-12s %12.1f %14s\n", "linear", linearNs, "-");
+  const double floatNs = time_picking(pick_float, repeats);
+  memcpy(floatPicks, picked, positionCount);
+  printf("%-12s %12.1f %14s\n", "mlp float", floatNs, "-");
+  const double int8Ns = time_picking(pick_int8, repeats);
+  int same = 0;
+  for (int p = 0; p < positionCount; p++) same += picked[p] == floatPicks[p];
+  printf("%-12s %12.1f %13.2f%%\n", "mlp int8", int8Ns, 100.0 * same / positionCount);
+
+  const bool ranked = check_mnk_ranking();
+
+  free(floatPicks);
+  free(positions);
+  free(picked);
+  ml_free(&model);
+  return ranked ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Converts a text dataset ("x,o,b,...,positive" per line) into the packed
+// binary format of packed_dataset.h, then loads both files back, checks they
+// hold the same rows and prints their sizes and median load times.
+//
+// Usage: pack-dataset [input output repeats]   (run from the repository root)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+
+// Median time in ms to load filename, model keeps the last load
+static double time_load(const char *filename, MLModel *model, int repeats) {
+  double ms[BENCH_MAX_REPEATS];
+  for (int r = 0; r < repeats; r++) {
+    ml_free(model);
+    DatasetError error;
+    const double start = search_now_ms();
+    const bool ok = load_data(filename, model, &error);
+    ms[r] = search_now_ms() - start;
+    if (!ok) {
+      print_dataset_error(filename, &error);
+      return -1;
+    }
+  }
+  return bench_median(ms, repeats);
+}
+
+static long long file_size(const char *filename) {
+  MappedFile file;
+  if (!mapped_file_open(filename, &file)) return -1;
+  const long long size = (long long)file.size;
+  mapped_file_close(&file);
+  return size;
+}
+
+int main(int argc, char **argv) {
+  const char *input = DATASET_FILE;
+  const char *output = DATASET_PACKED_FILE;
+  int repeats = 21;
+
+  if (argc >= 3) {
+    input = argv[1];
+    output = argv[2];
+  }
+  if (argc >= 4) repeats = atoi(argv[3]);
+  if (argc == 2 || repeats < 1 || repeats > BENCH_MAX_REPEATS) {
+    printf("Usage: %s [input output repeats (1-%d)]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+  MLModel text = {0};
+  MLModel packed = {0};
+  const double textMs = time_load(input, &text, repeats);
+  if (textMs < 0) return 1;
+
+  if (!packed_write(output, text.features, text.labels, MAX_FEATURES, text.sampleCount)) {
+    printf("Error writing '%s'.\n", output);
+    return 1;
+  }
+
+  const double packedMs = time_load(output, &packed, repeats);
+  if (packedMs < 0) return 1;
+  if (packed.sampleCount != text.sampleCount ||
+      memcmp(packed.features, text.features, (size_t)text.sampleCount * MAX_FEATURES) != 0 ||
+      memcmp(packed.labels, text.labels, (size_t)text.sampleCount) != 0) {
+    printf("Error, '%s' does not hold the same rows as '%s'.\n", output, input);
+    return 1;
+  }
+
+  const long long textSize = file_size(input);
+  const long long packedSize = file_size(output);
+  printf("Packed %d rows from '%s' into '%s'\n", text.sampleCount, input, output);
+  printf("%-8s %12s %10s %14s\n", "format", "bytes", "ms/load", "rows/sec");
+  printf("%-8s %12lld %10.3f %14.0f\n", "text", textSize, textMs,
+         text.sampleCount / (textMs / 1000.0));
+  printf("%-8s %12lld %10.3f %14.0f\n", "packed", packedSize, packedMs,
+         packed.sampleCount / (packedMs / 1000.0));
+  printf("%.1fx smaller, %.1fx faster to load\n", (double)textSize / packedSize,
+         textMs / packedMs);
+
+  ml_free(&text);
+  ml_free(&packed);
+  return 0;
+}
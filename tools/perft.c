@@ -0,0 +1,123 @@
+// Exhaustive game tree enumeration (perft) from a position: positions,
+// wins, losses and draws per ply, then nodes/sec of every backend on 1, 2,
+// 4... threads, checking all of them count the same tree. From the empty
+// 3x3 board the totals are also checked against the known figures
+// (549,946 positions, 255,168 games: 131,184 X wins, 77,904 O wins,
+// 46,080 draws).
+//
+// position is one character per cell, row by row: x, o, or . for empty.
+// "start" is the empty board. Wins and losses are for the side to move.
+//
+// Usage: perft [rows cols k position maxThreads repeats]
+//        e.g. perft 3 3 3 x...o.... 4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+
+static PerftCounts counts, reference;  // Too big for the stack
+
+static bool parse_position(MnkVariant variant, const char *text, MnkBoard *board) {
+  mnk_clear(board);
+  if (strcmp(text, "start") == 0) return true;
+  if ((int)strlen(text) != mnk_cells(variant)) return false;
+  for (int cell = 0; cell < mnk_cells(variant); cell++) {
+    const char c = text[cell];
+    if (c == 'x' || c == 'X') mnk_make_move(variant, board, cell, X);
+    else if (c == 'o' || c == 'O') mnk_make_move(variant, board, cell, O);
+    else if (c != '.' && c != '-') return false;
+  }
+  return true;
+}
+
+static bool same_counts(const PerftCounts *a, const PerftCounts *b) {
+  if (a->plies != b->plies) return false;
+  for (int ply = 0; ply <= a->plies; ply++) {
+    if (a->nodes[ply] != b->nodes[ply] || a->xWins[ply] != b->xWins[ply] ||
+        a->oWins[ply] != b->oWins[ply] || a->draws[ply] != b->draws[ply]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  MnkVariant variant = {3, 3, 3};
+  const char *position = "start";
+  int maxThreads = threadpool_cpu_count();
+  int repeats = 5;
+
+  if (argc >= 4) {
+    variant.rows = atoi(argv[1]);
+    variant.cols = atoi(argv[2]);
+    variant.k = atoi(argv[3]);
+  }
+  if (argc >= 5) position = argv[4];
+  if (argc >= 6) maxThreads = atoi(argv[5]);
+  if (argc >= 7) repeats = atoi(argv[6]);
+  MnkBoard board;
+  if (!mnk_variant_valid(variant) || !parse_position(variant, position, &board) ||
+      maxThreads < 1 || repeats < 1 || repeats > BENCH_MAX_REPEATS) {
+    printf("Usage: %s [rows cols k position maxThreads repeats (1-%d)]\n", argv[0], BENCH_MAX_REPEATS);
+    printf("position: x, o or . per cell row by row, or start for the empty board\n");
+    return 1;
+  }
+
+  const PerftBackend first = mnk_is_classic(variant) ? PERFT_BITBOARD : PERFT_MNK;
+  if (!perft_run(variant, &board, first, maxThreads, &reference)) {
+    printf("The position is illegal or the game is already over.\n");
+    return 1;
+  }
+  const int mover = board.moves % 2 == 0 ? X : O;
+
+  printf("Board %s, %s to move, %d cores\n", mnk_variant_name(variant), mover == X ? "X" : "O",
+         threadpool_cpu_count());
+  printf("%4s %16s %16s %16s %16s\n", "ply", "positions", "wins", "losses", "draws");
+  for (int ply = 0; ply <= reference.plies; ply++) {
+    const unsigned long long wins = mover == X ? reference.xWins[ply] : reference.oWins[ply];
+    const unsigned long long losses = mover == X ? reference.oWins[ply] : reference.xWins[ply];
+    printf("%4d %16llu %16llu %16llu %16llu\n", ply, reference.nodes[ply], wins, losses,
+           reference.draws[ply]);
+  }
+  const unsigned long long nodes = perft_total_nodes(&reference);
+  printf("%4s %16llu %16s %16s %16s\n", "all", nodes, "", "", "");
+  printf("%llu games\n", perft_total_games(&reference));
+
+  if (mnk_is_classic(variant) && board.moves == 0) {
+    unsigned long long xWins = 0, oWins = 0, draws = 0;
+    for (int ply = 0; ply <= reference.plies; ply++) {
+      xWins += reference.xWins[ply];
+      oWins += reference.oWins[ply];
+      draws += reference.draws[ply];
+    }
+    const bool known = nodes == 549946 && xWins == 131184 && oWins == 77904 && draws == 46080;
+    printf("Known 3x3 totals: %s\n", known ? "OK" : "MISMATCH");
+  }
+
+  printf("\n%-10s %8s %10s %14s %8s %s\n", "backend", "threads", "ms", "nodes/sec", "speedup",
+         "counts");
+  bool allSame = true;
+  for (int b = 0; b < NUM_PERFT_BACKENDS; b++) {
+    if (!perft_backend_supports((PerftBackend)b, variant)) continue;
+    double baseRate = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+      double ms[BENCH_MAX_REPEATS];
+      for (int r = 0; r < repeats; r++) {
+        const double start = search_now_ms();
+        perft_run(variant, &board, (PerftBackend)b, threads, &counts);
+        ms[r] = search_now_ms() - start;
+      }
+      const double median = bench_median(ms, repeats);
+      const bool same = same_counts(&counts, &reference);
+      const double rate = nodes / (median / 1000.0);
+      if (threads == 1) baseRate = rate;
+      allSame &= same;
+      printf("%-10s %8d %10.2f %14.0f %7.2fx %s\n", perft_backend_name((PerftBackend)b), threads,
+             median, rate, rate / baseRate, same ? "same" : "DIFFERENT");
+    }
+  }
+  return allSame ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// Retrograde solver: writes the perfect-play table of a small m,n,k variant
+// for the IMPOSSIBLE bot (main --retro FILE), then checks it. On 3x3 every
+// reachable position must match the solver table, on other boards random
+// positions near the end are solved again with plain negamax. Prints the
+// value of the empty board, positions/sec and the layer memory used.
+//
+// Usage: retro [rows cols k threads memoryMB file samples]
+//        e.g. retro 4 4 4 8 1024 retro_4x4_4.bin
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/engine.h"
+
+#define CHECK_EMPTY_CELLS 9  // Sampled positions leave this many cells for negamax
+
+// Exact score for the side to move, on the same scale as the table
+static int negamax(MnkVariant variant, MnkBoard *board, int player, int lastMove) {
+  if (lastMove >= 0 && mnk_is_win_at(variant, board, lastMove)) return -RETRO_WIN;
+  if (mnk_is_full(variant, board)) return 0;
+  int best = -RETRO_WIN - 1;
+  for (int w = 0; w < MNK_WORDS; w++) {
+    uint64_t moves = mnk_empty_word(variant, board, w);
+    while (moves) {
+      const int cell = mnk_pop_lsb(&moves, w);
+      mnk_make_move(variant, board, cell, player);
+      int value = -negamax(variant, board, -player, cell);
+      mnk_unmake_move(variant, board, cell);
+      if (value > 0) value--;
+      if (value < 0) value++;
+      if (value > best) best = value;
+    }
+  }
+  return best;
+}
+
+// Every reachable 3x3 position against the solver table, whose scores are
+// the same but counted down from SOLVER_WIN
+static int check_classic(const RetroTable *table, int *checked) {
+  int mismatches = 0;
+  *checked = 0;
+  solver_init();
+  for (int x = 0; x < 1 << BB_CELLS; x++) {
+    for (int o = 0; o < 1 << BB_CELLS; o++) {
+      const Bitboard board = {(BBMask)x, (BBMask)o};
+      if (x & o || solver_score(board) == SOLVER_UNKNOWN) continue;
+      const int expected = solver_score(board);
+      const int shift = (expected > 0) - (expected < 0);
+      MnkBoard mnk;
+      mnk_from_bitboard(&mnk, board);
+      mismatches += retro_score(table, &mnk) != expected + shift * (RETRO_WIN - SOLVER_WIN);
+      (*checked)++;
+    }
+  }
+  return mismatches;
+}
+
+// Random games stopped CHECK_EMPTY_CELLS cells from the end, solved again
+static int check_samples(const RetroTable *table, int samples, int *checked) {
+  const MnkVariant variant = table->variant;
+  int mismatches = 0;
+  *checked = 0;
+  srand(1);
+  for (int s = 0; s < samples; s++) {
+    MnkBoard board;
+    mnk_clear(&board);
+    int player = X, lastMove = -1;
+    bool over = false;
+    while (!over && mnk_cells(variant) - board.moves > CHECK_EMPTY_CELLS) {
+      int moves[MNK_MAX_CELLS], count = 0;
+      for (int w = 0; w < MNK_WORDS; w++) {
+        uint64_t empty = mnk_empty_word(variant, &board, w);
+        while (empty) moves[count++] = mnk_pop_lsb(&empty, w);
+      }
+      lastMove = moves[rand() % count];
+      mnk_make_move(variant, &board, lastMove, player);
+      over = mnk_check_winner(variant, &board, lastMove) != EMPTY;
+      player = -player;
+    }
+    mismatches += retro_score(table, &board) != negamax(variant, &board, player, lastMove);
+    (*checked)++;
+  }
+  return mismatches;
+}
+
+int main(int argc, char **argv) {
+  MnkVariant variant = {4, 4, 4};
+  int threads = threadpool_cpu_count();
+  long memoryMB = RETRO_MEMORY_MB;
+  char filename[256] = "";
+  int samples = 2000;
+
+  if (argc >= 4) {
+    variant.rows = atoi(argv[1]);
+    variant.cols = atoi(argv[2]);
+    variant.k = atoi(argv[3]);
+  }
+  if (argc >= 5) threads = atoi(argv[4]);
+  if (argc >= 6) memoryMB = atol(argv[5]);
+  if (argc >= 7) snprintf(filename, sizeof(filename), "%s", argv[6]);
+  if (argc >= 8) samples = atoi(argv[7]);
+  if (filename[0] == '\0') {
+    snprintf(filename, sizeof(filename), "retro_%dx%d_%d.bin", variant.rows, variant.cols,
+             variant.k);
+  }
+  if (!mnk_variant_valid(variant) || mnk_cells(variant) > RETRO_MAX_CELLS || threads < 1 ||
+      memoryMB < 1 || samples < 0) {
+    printf("Usage: %s [rows cols k threads memoryMB file samples]\n", argv[0]);
+    printf("boards of up to %d cells\n", RETRO_MAX_CELLS);
+    return 1;
+  }
+  const size_t memoryLimit = (size_t)memoryMB << 20;
+  if (!retro_supports(variant, memoryLimit)) {
+    printf("%s needs %.0f MB for its two largest layers, over the %ld MB limit\n",
+           mnk_variant_name(variant), retro_memory_needed(variant) / 1048576.0, memoryMB);
+    return 1;
+  }
+
+  printf("Board %s, %d threads, %d cores\n", mnk_variant_name(variant), threads,
+         threadpool_cpu_count());
+  RetroStats stats;
+  if (!retro_solve(variant, filename, threads, memoryLimit, &stats)) {
+    printf("Could not solve to %s\n", filename);
+    return 1;
+  }
+  const char *value = stats.rootScore > 0 ? "X wins" : stats.rootScore < 0 ? "O wins" : "draw";
+  printf("%llu positions in %.1f ms, %.0f positions/sec, %.1f MB of layers held\n",
+         (unsigned long long)stats.positions, stats.ms, stats.positions / (stats.ms / 1000.0),
+         stats.peakBytes / 1048576.0);
+  printf("Side to move wins %llu, draws %llu, loses %llu\n", (unsigned long long)stats.wins,
+         (unsigned long long)stats.draws, (unsigned long long)stats.losses);
+  if (stats.rootScore == 0) printf("Empty board: %s\n", value);
+  else printf("Empty board: %s in %d plies\n", value, RETRO_WIN - abs(stats.rootScore));
+  printf("Wrote %s\n", filename);
+
+  RetroTable table;
+  if (!retro_open(filename, &table)) {
+    printf("Could not read back %s\n", filename);
+    return 1;
+  }
+  int checked, mismatches;
+  if (mnk_is_classic(variant)) {
+    mismatches = check_classic(&table, &checked);
+    printf("Checked %d positions against the 3x3 solver: %d mismatches\n", checked, mismatches);
+  } else {
+    mismatches = check_samples(&table, samples, &checked);
+    printf("Checked %d random positions against negamax: %d mismatches\n", checked, mismatches);
+  }
+  retro_close(&table);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Parallel root search scaling report: runs the same fixed depth searches
+// with 1, 2, 4... threads and prints nodes/sec and wall-clock speed-up per
+// thread count, checking that every thread count picks the same moves.
+// Then checks that iterative deepening to the same depth also returns the
+// same best and second moves and scores on every thread count. Also
+// reports the share of transposition table probes that hit.
+//
+// Usage: search-bench [rows cols k depth maxThreads]
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/engine.h"
+
+// Opening stones played before each timed search, -1 terminated, X first
+static const int OPENINGS[][8] = {
+    {24, -1},
+    {24, 25, 17, -1},
+    {24, 32, 16, 25, -1},
+};
+#define NUM_OPENINGS (int)(sizeof(OPENINGS) / sizeof(OPENINGS[0]))
+
+static void play_opening(MnkVariant variant, int opening, MnkBoard *board, int *player) {
+  mnk_clear(board);
+  *player = X;
+  for (int j = 0; OPENINGS[opening][j] >= 0; j++) {
+    // Keep the openings on the board for small variants
+    mnk_make_move(variant, board, OPENINGS[opening][j] % mnk_cells(variant), *player);
+    *player = -*player;
+  }
+}
+
+static bool same_result(SearchResult a, SearchResult b) {
+  return a.bestMove == b.bestMove && a.bestScore == b.bestScore &&
+         a.secondMove == b.secondMove && a.secondScore == b.secondScore;
+}
+
+int main(int argc, char **argv) {
+  MnkVariant variant = {7, 7, 4};
+  int depth = 4;
+  int maxThreads = threadpool_cpu_count();
+
+  if (argc >= 4) {
+    variant.rows = atoi(argv[1]);
+    variant.cols = atoi(argv[2]);
+    variant.k = atoi(argv[3]);
+  }
+  if (argc >= 5) depth = atoi(argv[4]);
+  if (argc >= 6) maxThreads = atoi(argv[5]);
+  if (!mnk_variant_valid(variant) || depth < 1 || maxThreads < 1) {
+    printf("Usage: %s [rows cols k depth maxThreads]\n", argv[0]);
+    return 1;
+  }
+
+  printf("Board %s, depth %d, %d cores\n", mnk_variant_name(variant), depth,
+         threadpool_cpu_count());
+  printf("%8s %10s %14s %14s %8s %8s %s\n", "threads", "time ms", "nodes", "nodes/sec",
+         "speedup", "tt hits", "result");
+
+  double baseTime = 0;
+  SearchResult base[NUM_OPENINGS];
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    search_set_threads(threads);
+    unsigned long long int nodes = 0;
+    bool same = true;
+    tt_clear();  // Every thread count starts from an empty table
+    const unsigned long long int probes = ttProbes, hits = ttHits;
+    double start = search_now_ms();
+
+    for (int i = 0; i < NUM_OPENINGS; i++) {
+      MnkBoard board;
+      int player;
+      play_opening(variant, i, &board, &player);
+      SearchResult result = search_root(variant, &board, player, depth);
+      nodes += result.nodes;
+      if (threads == 1) base[i] = result;
+      else same &= same_result(base[i], result);
+    }
+
+    double elapsed = search_now_ms() - start;
+    double rate = nodes / (elapsed / 1000.0);
+    if (threads == 1) baseTime = elapsed;
+    printf("%8d %10.1f %14llu %14.0f %7.2fx %7.1f%% %s\n", threads, elapsed, nodes, rate,
+           baseTime / elapsed, 100.0 * (ttHits - hits) / (ttProbes - probes + 1e-10),
+           same ? "same" : "DIFFERENT");
+  }
+
+  // No time limit, so every thread count finishes the same iterations. The
+  // table stays warm from the runs before, which must not change results
+  printf("\nIterative deepening to depth %d\n", depth);
+  printf("%8s %s\n", "threads", "result");
+  bool allSame = true;
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    search_set_threads(threads);
+    bool same = true;
+    for (int i = 0; i < NUM_OPENINGS; i++) {
+      MnkBoard board;
+      int player;
+      play_opening(variant, i, &board, &player);
+      SearchResult result = search_iterative(variant, &board, player, 1e12, depth, NULL);
+      if (threads == 1) base[i] = result;
+      else same &= same_result(base[i], result);
+    }
+    allSame &= same;
+    printf("%8d %s\n", threads, same ? "same" : "DIFFERENT");
+  }
+  return allSame ? 0 : 1;
+}
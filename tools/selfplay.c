@@ -0,0 +1,144 @@
+// Self-play data generator: plays games between the given players on 1, 2,
+// 4... threads up to maxThreads, each run writing every position with the move
+// played and the game's outcome to output (see core/selfplay.h for the
+// format). Prints games/sec, positions/sec and speed-up per thread count,
+// checks every thread count played the same games, then reads the file of
+// the last run back and checks its header, checksum and records.
+//
+// Players: random, minimax:N (N plies, 1-9), perfect, ml (linear model)
+// and mlp (int8 MLP). The models are trained on the UCI dataset first.
+//
+// output defaults to selfplay.bin in the current directory, like the tables
+// retro writes. The ml and mlp players load ./core/dataset/tic-tac-toe.data,
+// which both the repository root and build/ hold.
+//
+// Usage: selfplay [games maxThreads output players]
+//        e.g. selfplay 200000 8 build/selfplay.bin random,minimax:2,perfect
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+
+#define MAX_PLAYERS 16
+#define DEFAULT_PLAYERS "random,minimax:1,minimax:2,minimax:4,perfect,ml,mlp"
+
+static MLModel model;
+
+// Train the models the players need, false when the dataset cannot be loaded
+static bool train_models(const SelfPlayer *players, int playerCount) {
+  bool linear = false, mlp = false;
+  for (int p = 0; p < playerCount; p++) {
+    linear |= players[p].kind == SELFPLAY_ML;
+    mlp |= players[p].kind == SELFPLAY_MLP;
+  }
+  if (!linear && !mlp) return true;
+
+  DatasetError error;
+  if (!load_data(DATASET_FILE, &model, &error)) {
+    print_dataset_error(DATASET_FILE, &error);
+    return false;
+  }
+  srand(1);  // Same models every run
+  model.trainSplit = 0.8;
+  shuffle_data(&model);
+  split_data(&model);
+  if (linear) {
+    model.config = train_config(OPTIMIZER_NORMAL);
+    train_linear_regression(&model);
+  }
+  if (mlp) train_mlp(&model);
+  return true;
+}
+
+// Read filename back: header, checksum, every record legal and the
+// outcomes matching stats
+static bool check_file(const char *filename, const SelfPlayStats *stats) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) return false;
+
+  PackedHeader header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SELFPLAY_MAGIC &&
+            header.version == SELFPLAY_VERSION && header.featureCount == BB_CELLS &&
+            header.rowCount == (uint64_t)stats->positions;
+  uint64_t checksum = 14695981039346656037ull;
+  long long outcomes[3] = {0, 0, 0};  // Counted on each game's opening position
+  uint32_t block[4096];
+  size_t read;
+  while (ok && (read = fread(block, sizeof(uint32_t), 4096, file)) > 0) {
+    checksum = packed_checksum(checksum, block, read);
+    for (size_t i = 0; i < read; i++) {
+      Bitboard board;
+      int move, winner;
+      selfplay_unpack(block[i], &board, &move, &winner);
+      ok &= move < BB_CELLS && (bb_empty(board) & (1u << move)) && bb_check_winner(board) == EMPTY;
+      if (board.x == 0 && board.o == 0) outcomes[winner == X ? 1 : winner == O ? 2 : 0]++;
+    }
+  }
+  fclose(file);
+  return ok && checksum == header.checksum &&
+         memcmp(outcomes, stats->outcomes, sizeof(outcomes)) == 0;
+}
+
+int main(int argc, char **argv) {
+  long long games = 200000;
+  int maxThreads = threadpool_cpu_count();
+  const char *output = "selfplay.bin";
+  char specs[512] = DEFAULT_PLAYERS;
+
+  if (argc >= 2) games = atoll(argv[1]);
+  if (argc >= 3) maxThreads = atoi(argv[2]);
+  if (argc >= 4) output = argv[3];
+  if (argc >= 5) snprintf(specs, sizeof(specs), "%s", argv[4]);
+
+  SelfPlayer players[MAX_PLAYERS];
+  int playerCount = 0;
+  bool valid = games >= 1 && maxThreads >= 1 && output[0] != '\0';
+  for (char *spec = strtok(specs, ","); spec != NULL && valid; spec = strtok(NULL, ",")) {
+    valid = playerCount < MAX_PLAYERS && selfplay_parse_player(spec, &players[playerCount++]);
+  }
+  if (!valid || playerCount == 0) {
+    printf("Usage: %s [games maxThreads output players]\n", argv[0]);
+    printf("players: comma separated random, minimax:N (1-%d), perfect, ml, mlp\n",
+           SELFPLAY_MAX_DEPTH);
+    return 1;
+  }
+  if (!train_models(players, playerCount)) return 1;
+
+  SelfPlayConfig config = {players, playerCount, model.weights, &model.mlpInt8, games,
+                           0x5454545454545454ULL};
+  printf("%lld games, %d cores, players", games, threadpool_cpu_count());
+  for (int p = 0; p < playerCount; p++) {
+    char name[32];
+    selfplay_player_name(players[p], name, sizeof(name));
+    printf(" %s", name);
+  }
+  printf("\n%8s %10s %14s %14s %8s %s\n", "threads", "time ms", "games/sec", "positions/sec",
+         "speedup", "X/O/draw");
+
+  SelfPlayStats stats, first;
+  double baseRate = 0;
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    if (!selfplay_run(&config, output, threads, &stats)) {
+      printf("Error writing '%s'.\n", output);
+      return 1;
+    }
+    const double rate = stats.games / (stats.ms / 1000.0);
+    if (threads == 1) {
+      baseRate = rate;
+      first = stats;
+    }
+    const bool same = stats.positions == first.positions &&
+                      memcmp(stats.outcomes, first.outcomes, sizeof(stats.outcomes)) == 0;
+    printf("%8d %10.1f %14.0f %14.0f %7.2fx %lld/%lld/%lld%s\n", threads, stats.ms, rate,
+           stats.positions / (stats.ms / 1000.0), rate / baseRate, stats.outcomes[1],
+           stats.outcomes[2], stats.outcomes[0], same ? "" : " (differs from 1 thread)");
+  }
+
+  const bool checked = check_file(output, &stats);
+  printf("\nWrote %lld positions (%.1f MB) to '%s', read back %s\n", stats.positions,
+         (sizeof(PackedHeader) + stats.positions * sizeof(uint32_t)) / 1e6, output,
+         checked ? "OK" : "with ERRORS");
+  ml_free(&model);
+  return checked ? 0 : 1;
+}
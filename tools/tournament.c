@@ -0,0 +1,151 @@
+// Round-robin tournament between the game's bots on any m,n,k board:
+// every pair of players meets `games` times with colours alternating, on
+// `threads` threads. Prints each pairing's wins, draws and losses with the
+// Elo difference they imply, then every player's rating with its 95%
+// margin, and games/sec. Run it before and after a change to check the bots
+// did not get weaker.
+//
+// Players are the GUI's bots, with the GUI's randomisation: minimax (the
+// IMPOSSIBLE bot, second best move 30% of the time, /P for P%), ml and mlp
+// (the NORMAL bot with either model), mcts (the MONTE_CARLO bot, :N for N
+// playouts per move) and random as a baseline.
+//
+// Usage: tournament [games threads players rows cols k]   (run from the repository root)
+//        e.g. tournament 200 8 random,minimax,mcts:2000 7 7 4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+
+#define DEFAULT_PLAYERS "random,ml,mlp,mcts:1000,mcts,minimax,minimax/0"
+
+static MLModel model;
+static MLModel network;  // Same data and weights as model, played as the MLP
+
+// Train the models the players need, false when the dataset cannot be loaded
+static bool train_models(const TournamentPlayer *players, int playerCount) {
+  bool linear = false, mlp = false;
+  for (int p = 0; p < playerCount; p++) {
+    linear |= players[p].kind == TOURNAMENT_ML;
+    mlp |= players[p].kind == TOURNAMENT_MLP;
+  }
+  if (!linear && !mlp) return true;
+
+  DatasetError error;
+  if (!load_data(DATASET_FILE, &model, &error)) {
+    print_dataset_error(DATASET_FILE, &error);
+    return false;
+  }
+  srand(1);  // Same models every run
+  model.trainSplit = 0.8;
+  shuffle_data(&model);
+  split_data(&model);
+  if (linear) {
+    model.config = train_config(OPTIMIZER_NORMAL);
+    train_linear_regression(&model);
+  }
+  if (mlp) train_mlp(&model);
+  model.kind = MODEL_LINEAR;
+  network = model;
+  network.kind = MODEL_MLP;
+  return true;
+}
+
+// Elo and margin as text, "inf" when a side scored every point
+static void format_elo(double elo, double margin, char *out, int size) {
+  if (isinf(elo)) snprintf(out, size, "%cinf", elo < 0 ? '-' : '+');
+  else snprintf(out, size, "%+.0f +/- %.0f", elo, margin);
+}
+
+int main(int argc, char **argv) {
+  long long games = 100;
+  int threads = threadpool_cpu_count();
+  char specs[512] = DEFAULT_PLAYERS;
+  MnkVariant variant = MNK_PRESETS[0];
+
+  if (argc >= 2) games = atoll(argv[1]);
+  if (argc >= 3) threads = atoi(argv[2]);
+  if (argc >= 4) snprintf(specs, sizeof(specs), "%s", argv[3]);
+  if (argc >= 7) {
+    variant.rows = atoi(argv[4]);
+    variant.cols = atoi(argv[5]);
+    variant.k = atoi(argv[6]);
+  }
+
+  TournamentPlayer players[TOURNAMENT_MAX_PLAYERS];
+  char names[TOURNAMENT_MAX_PLAYERS][32];
+  int playerCount = 0;
+  bool valid = games >= 1 && threads >= 1 && mnk_variant_valid(variant);
+  for (char *spec = strtok(specs, ","); spec != NULL && valid; spec = strtok(NULL, ",")) {
+    valid = playerCount < TOURNAMENT_MAX_PLAYERS &&
+            tournament_parse_player(spec, &players[playerCount]);
+    if (valid) tournament_player_name(players[playerCount], names[playerCount], 32);
+    playerCount++;
+  }
+  if (!valid || playerCount < 2) {
+    printf("Usage: %s [games threads players rows cols k]\n", argv[0]);
+    printf("players: 2-%d of random, minimax, ml, mlp, mcts, comma separated, minimax\n",
+           TOURNAMENT_MAX_PLAYERS);
+    printf("optionally followed by /P to play the second best move P%% of the time (30 by\n");
+    printf("default) and mcts by :N for N playouts per move\n");
+    return 1;
+  }
+  if (!train_models(players, playerCount)) return 1;
+
+  aiLog = false;  // The engines would log every move
+  TournamentConfig config = {variant, players, playerCount, &model, &network};
+  TournamentTable table;
+  if (!tournament_run(&config, games, threads, &table)) {
+    printf("Could not start %d threads.\n", threads);
+    return 1;
+  }
+
+  printf("%s, %d players, %lld games per pairing, %d threads\n\n", mnk_variant_name(variant),
+         playerCount, games, threads);
+  printf("%-14s %-14s %8s %8s %8s %8s %16s\n", "player", "opponent", "wins", "draws", "losses",
+         "score", "elo diff");
+  for (int i = 0; i < playerCount; i++) {
+    for (int j = i + 1; j < playerCount; j++) {
+      const TournamentScore s = table.score[i][j];
+      double elo, margin;
+      char text[32];
+      tournament_pair_elo(s, &elo, &margin);
+      format_elo(elo, margin, text, sizeof(text));
+      printf("%-14s %-14s %8lld %8lld %8lld %7.1f%% %16s\n", names[i], names[j], s.wins, s.draws,
+             s.losses, 100.0 * (s.wins + 0.5 * s.draws) / games, text);
+    }
+  }
+
+  // Ratings, strongest first
+  double elo[TOURNAMENT_MAX_PLAYERS], margin[TOURNAMENT_MAX_PLAYERS];
+  int order[TOURNAMENT_MAX_PLAYERS];
+  tournament_ratings(&table, elo, margin);
+  for (int i = 0; i < playerCount; i++) {
+    int at = i;
+    while (at > 0 && elo[order[at - 1]] < elo[i]) {
+      order[at] = order[at - 1];
+      at--;
+    }
+    order[at] = i;
+  }
+
+  printf("\n%4s %-14s %8s %8s %8s %8s %8s\n", "rank", "player", "elo", "+/-", "wins", "draws",
+         "losses");
+  for (int r = 0; r < playerCount; r++) {
+    const int i = order[r];
+    long long wins = 0, draws = 0, losses = 0;
+    for (int j = 0; j < playerCount; j++) {
+      wins += table.score[i][j].wins;
+      draws += table.score[i][j].draws;
+      losses += table.score[i][j].losses;
+    }
+    printf("%4d %-14s %8.0f %8.0f %8lld %8lld %8lld\n", r + 1, names[i], elo[i], margin[i], wins,
+           draws, losses);
+  }
+
+  printf("\n%lld games in %.1f ms, %.0f games/sec\n", table.games, table.ms,
+         table.games / (table.ms / 1000.0));
+  ml_free(&model);
+  return 0;
+}
@@ -0,0 +1,217 @@
+// Training throughput report: runs the full-batch gradient descent of
+// train_linear_regression on the UCI dataset with the original int/double
+// loop, the scalar float kernel and the vectorised kernel, and prints
+// epochs/sec and how far each one's weights end up from the original.
+// Then the dataset is repeated copies times and trained with 1, 2, 4...
+// threads to show how the threaded gradients scale on large datasets.
+// Last every optimizer (and the closed-form solve) trains the model the way ml_init does, reporting
+// epochs until early stopping, training MSE, test F1 and wall time.
+//
+// Usage: train-bench [epochs repeats copies maxThreads]   (run from the repository root)
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/engine.h"
+#include "bench_util.h"
+
+#define THREAD_EPOCHS 20  // Epochs per timing in the thread scaling part
+
+typedef void (*GradientFn)(const TrainSet *set, const double *weights, int begin, int end,
+                           double *gradient);
+
+static MLModel model;
+
+// The training loop as it was before the kernel, kept as the baseline
+static void train_original(int epochs, double weights[MAX_FEATURES + 1]) {
+  for (int epoch = 0; epoch < epochs; epoch++) {
+    double gradient[MAX_FEATURES + 1] = {0};
+    for (int i = 0; i < model.trainSize; i++) {
+      double predicted = weights[MAX_FEATURES];
+      for (int j = 0; j < MAX_FEATURES; j++) predicted += ml_sample(&model, i)[j] * weights[j];
+      double error = predicted - model.labels[i];
+      for (int j = 0; j < MAX_FEATURES; j++) gradient[j] += error * ml_sample(&model, i)[j];
+      gradient[MAX_FEATURES] += error;
+    }
+    for (int j = 0; j <= MAX_FEATURES; j++) {
+      weights[j] -= LEARNING_RATE * gradient[j] / model.trainSize;
+    }
+  }
+}
+
+static void train_kernel(const TrainSet *set, GradientFn gradientFn, int epochs,
+                         double weights[MAX_FEATURES + 1]) {
+  for (int epoch = 0; epoch < epochs; epoch++) {
+    double gradient[TRAIN_OUTPUTS(MAX_FEATURES)];
+    gradientFn(set, weights, 0, set->padded, gradient);
+    for (int j = 0; j <= MAX_FEATURES; j++) {
+      weights[j] -= LEARNING_RATE * gradient[j] / set->count;
+    }
+  }
+}
+
+// Train from zero weights and return the median time of repeats in seconds
+static double time_training(const TrainSet *set, GradientFn gradientFn, int epochs, int repeats,
+                            double weights[MAX_FEATURES + 1]) {
+  double seconds[BENCH_MAX_REPEATS];
+  for (int r = 0; r < repeats; r++) {
+    for (int j = 0; j <= MAX_FEATURES; j++) weights[j] = 0;
+    double start = search_now_ms();
+    if (gradientFn == NULL)
+      train_original(epochs, weights);
+    else
+      train_kernel(set, gradientFn, epochs, weights);
+    seconds[r] = (search_now_ms() - start) / 1000.0;
+  }
+  return bench_median(seconds, repeats);
+}
+
+// Same signature as the kernels, for timing the threaded path
+static void threaded_gradient(const TrainSet *set, const double *weights, int begin, int end,
+                              double *gradient) {
+  (void)begin;
+  (void)end;
+  train_gradient_threaded(set, weights, gradient);
+}
+
+// Thread scaling on the training rows repeated copies times
+static void bench_threads(int copies, int repeats, int maxThreads) {
+  TrainSet big;
+  if (!train_set_init(&big, MAX_FEATURES, model.trainSize * copies)) {
+    printf("Error allocating training data.\n");
+    return;
+  }
+  for (int i = 0; i < big.count; i++) {
+    int row = i % model.trainSize;
+    train_set_sample(&big, i, ml_sample(&model, row), model.labels[row]);
+  }
+
+  printf("\n%d samples, %d epochs, %d cores\n", big.count, THREAD_EPOCHS, threadpool_cpu_count());
+  printf("%-10s %12s %12s %10s %16s\n", "threads", "epochs/sec", "ms/train", "speedup",
+         "max weight diff");
+
+  double reference[MAX_FEATURES + 1];
+  double baseRate = 0;
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    double weights[MAX_FEATURES + 1];
+    train_set_threads(threads);
+    const double seconds = time_training(&big, threaded_gradient, THREAD_EPOCHS, repeats, weights);
+
+    double diff = 0;
+    for (int j = 0; j <= MAX_FEATURES; j++) {
+      if (threads == 1) reference[j] = weights[j];
+      diff = fmax(diff, fabs(weights[j] - reference[j]));
+    }
+
+    const double rate = THREAD_EPOCHS / seconds;
+    if (threads == 1) baseRate = rate;
+    printf("%-10d %12.1f %12.2f %9.2fx %16.2e\n", threads, rate, seconds * 1000.0,
+           rate / baseRate, diff);
+  }
+  train_set_free(&big);
+}
+
+// F1 score on the test split, as evaluate_and_print_model_metrics computes it
+static double test_f1(MLModel *trained) {
+  calculate_confusion_matrix(trained, 0);
+  double precision =
+      (double)trained->truePositives / (trained->truePositives + trained->falsePositives + 1e-10);
+  double recall =
+      (double)trained->truePositives / (trained->truePositives + trained->falseNegatives + 1e-10);
+  return 2 * (precision * recall) / (precision + recall + 1e-10);
+}
+
+// Full train_linear_regression runs with each optimizer's default settings
+static void bench_optimizers(int repeats) {
+  static MLModel trained;
+
+  printf("\n%-10s %8s %10s %12s %10s %10s\n", "optimizer", "epochs", "train MSE", "ms/train",
+         "speedup", "test F1");
+
+  double baseTime = 0;
+  for (int i = 0; i < NUM_OPTIMIZERS; i++) {
+    double seconds[BENCH_MAX_REPEATS];
+    for (int r = 0; r < repeats; r++) {
+      trained = model;
+      memset(trained.weights, 0, sizeof(trained.weights));
+      trained.config = train_config((Optimizer)i);
+      srand(1);  // Same batch order every repeat
+      double start = search_now_ms();
+      train_linear_regression(&trained);
+      seconds[r] = (search_now_ms() - start) / 1000.0;
+    }
+    const double median = bench_median(seconds, repeats);
+    if (i == OPTIMIZER_GD) baseTime = median;
+    printf("%-10s %8d %10.4f %12.2f %9.2fx %10.4f\n", optimizer_name((Optimizer)i),
+           trained.epochsRun, trained.finalLoss, median * 1000.0, baseTime / median,
+           test_f1(&trained));
+  }
+}
+
+int main(int argc, char **argv) {
+  int epochs = EPOCHS;
+  int repeats = 5;
+  int copies = 1000;
+  int maxThreads = threadpool_cpu_count();
+
+  if (argc >= 2) epochs = atoi(argv[1]);
+  if (argc >= 3) repeats = atoi(argv[2]);
+  if (argc >= 4) copies = atoi(argv[3]);
+  if (argc >= 5) maxThreads = atoi(argv[4]);
+  if (epochs < 1 || repeats < 1 || repeats > BENCH_MAX_REPEATS || copies < 1 || maxThreads < 1) {
+    printf("Usage: %s [epochs repeats (1-%d) copies maxThreads]\n", argv[0], BENCH_MAX_REPEATS);
+    return 1;
+  }
+
+  srand(1);  // Same shuffle every run
+  model.trainSplit = 0.8;
+  DatasetError error;
+  if (!load_data(DATASET_FILE, &model, &error)) {
+    print_dataset_error(DATASET_FILE, &error);
+    return 1;
+  }
+  shuffle_data(&model);
+  split_data(&model);
+
+  TrainSet set;
+  if (!train_set_init(&set, MAX_FEATURES, model.trainSize)) {
+    printf("Error allocating training data.\n");
+    return 1;
+  }
+  for (int i = 0; i < model.trainSize; i++) {
+    train_set_sample(&set, i, ml_sample(&model, i), model.labels[i]);
+  }
+
+  printf("%d training samples, %d epochs, %d repeats, kernel backend: %s\n", model.trainSize,
+         epochs, repeats, train_backend());
+  printf("%-10s %12s %12s %10s %16s\n", "kernel", "epochs/sec", "ms/train", "speedup",
+         "max weight diff");
+
+  static const char *NAMES[] = {"original", "scalar", "simd"};
+  const GradientFn KERNELS[] = {NULL, train_gradient_scalar, train_gradient};
+  double reference[MAX_FEATURES + 1] = {0};
+  double baseRate = 0;
+
+  for (int k = 0; k < 3; k++) {
+    double weights[MAX_FEATURES + 1];
+    const double seconds = time_training(&set, KERNELS[k], epochs, repeats, weights);
+
+    double diff = 0;
+    for (int j = 0; j <= MAX_FEATURES; j++) {
+      if (k == 0) reference[j] = weights[j];
+      diff = fmax(diff, fabs(weights[j] - reference[j]));
+    }
+
+    const double rate = epochs / seconds;
+    if (k == 0) baseRate = rate;
+    printf("%-10s %12.0f %12.2f %9.2fx %16.2e\n", NAMES[k], rate, seconds * 1000.0,
+           rate / baseRate, diff);
+  }
+  train_set_free(&set);
+
+  bench_threads(copies, repeats, maxThreads);
+  train_set_threads(0);
+  bench_optimizers(repeats);
+  return 0;
+}